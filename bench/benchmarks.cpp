@@ -0,0 +1,455 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <thread>
+
+#include "BatchObjectives.h"
+#include "BatchSolver.h"
+#include "Genocop.h"
+#include "IslandModel.h"
+#include "Random.h"
+#include "Objectives.h"
+
+// Performance and quality benchmarks of Genocop:
+// - BM_Generation/<dimension>/<population>: generations/s and evaluations/s of step() on the sphere
+// - BM_Threads/<threads>: the same with several threads (0 = all hardware threads)
+// - Run/<function>: complete runs of maxIters generations
+// - TimeToTarget/<function>: runs until the target value; time, generations and success rate per run
+// - TimeToTarget/memetic/<function>: the same with Nelder-Mead refinement every 10 generations
+// - Objective/<function>/<dimension>: evaluations/s of the batch test functions on a population of 100
+// - Solve/<function>/<dimension>: complete runs on the shifted batch test functions
+// - Islands/<variant>: time to target of one big population and of islands with the same total size
+// - SteadyState/<mode>: generational vs steady-state runs when evaluation times vary between individuals
+// - BM_Jobs/<threads>: many small independent problems with BatchSolver (threads = 0 -> a new Genocop per job, serially)
+// Every run uses a fixed seed, so the numbers only change when the code does.
+
+struct Problem
+{
+    const char * name;
+    ObjectiveFunction objective;
+    uint32_t dimension;
+    double xMin;
+    double xMax;
+    double target;    // for TimeToTarget
+};
+
+static const Problem PROBLEMS[] =
+{
+    {"banana",     banana,     2,  -3,      3,      1e-4},
+    {"rastrigin",  rastrigin,  2,  -5.12,   5.12,   1e-3},
+    {"himmelblau", himmelblau, 2,  -5.12,   5.12,   1e-4},
+    {"levi13",     levi13,     2,  -10,     10,     1e-4},
+    {"f2d",        f2d,        2,  -10,     10,     1e-6},
+    {"sphere",     sphere,     10, -5.12,   5.12,   1e-3},
+    // targets of the harder ones are reached in about half of the runs
+    {"rastrigin10", rastrigin, 10, -5.12,   5.12,   20.0},
+    {"ackley",     ackley,     10, -32.768, 32.768, 10.0},
+    {"griewank",   griewank,   10, -600,    600,    4.0},
+};
+
+// Settings of the 2-D demos in main.cpp
+static Genocop::Options benchmarkOptions()
+{
+    Genocop::Options options;
+    options.eliteChildrenCount = 1;
+    options.tournament.p = 0.9;
+    options.tournament.size = 6;
+    options.mutatation.fineMutationMin = 1e-5;
+    options.mutatation.fineMutationMax = 0.2;
+    options.mutatation.pFull = 0.05;
+    options.mutatation.pFine = 0.2;
+    options.crossover.totalProbability = 0.8;
+    options.seed = 1;
+    return options;
+}
+
+// =============================================
+// ================= Throughput ================
+// =============================================
+
+static void stepBenchmark(benchmark::State & state, const uint32_t dimension, const uint32_t population,
+                          const uint32_t threads)
+{
+    Genocop optim(dimension, sphere, Vector(-5.12, dimension), Vector(5.12, dimension));
+
+    Genocop::Options options = benchmarkOptions();
+    options.populationCount = population;
+    options.parentsCount = population / 2;
+    options.threadCount = threads;
+    options.maxIters = 1000000000; // step() is called as long as the benchmark needs
+    optim.start(options);
+
+    const uint64_t startEvaluations = optim.evaluations();
+    for (auto _ : state)
+    {
+        optim.step();
+    }
+
+    state.counters["generations/s"] = benchmark::Counter(double(state.iterations()), benchmark::Counter::kIsRate);
+    state.counters["evaluations/s"] = benchmark::Counter(double(optim.evaluations() - startEvaluations), benchmark::Counter::kIsRate);
+}
+
+static void BM_Generation(benchmark::State & state)
+{
+    stepBenchmark(state, state.range(0), state.range(1), 1);
+}
+BENCHMARK(BM_Generation)
+    ->ArgNames({"dimension", "population"})
+    ->Args({1, 100})->Args({10, 100})->Args({100, 100})->Args({1000, 100})->Args({10000, 100})
+    ->Args({10, 20})->Args({10, 500})->Args({10, 2000})
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_Threads(benchmark::State & state)
+{
+    stepBenchmark(state, 1000, 1000, state.range(0));
+}
+BENCHMARK(BM_Threads)->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->Arg(0)
+    ->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// =============================================
+// ================ Complete runs ==============
+// =============================================
+
+static void runBenchmark(benchmark::State & state, const Problem & problem)
+{
+    Genocop optim(problem.dimension, problem.objective,
+                  Vector(problem.xMin, problem.dimension), Vector(problem.xMax, problem.dimension));
+
+    Genocop::Options options = benchmarkOptions();
+    options.maxIters = 200;
+
+    Vector solution;
+    double best = 0;
+    uint64_t evaluations = 0;
+    for (auto _ : state)
+    {
+        best += optim.run(solution, options);
+        evaluations += optim.evaluations();
+    }
+
+    state.counters["best"] = benchmark::Counter(best, benchmark::Counter::kAvgIterations);
+    state.counters["generations/s"] = benchmark::Counter(double(state.iterations()) * options.maxIters, benchmark::Counter::kIsRate);
+    state.counters["evaluations/s"] = benchmark::Counter(double(evaluations), benchmark::Counter::kIsRate);
+}
+
+// Runs with a new seed every iteration until the target or maxIters
+static void timeToTargetBenchmark(benchmark::State & state, const Problem & problem, const bool memetic)
+{
+    Genocop optim(problem.dimension, problem.objective,
+                  Vector(problem.xMin, problem.dimension), Vector(problem.xMax, problem.dimension));
+
+    Genocop::Options options = benchmarkOptions();
+    options.maxIters = 2000;
+    options.stop.targetValue = problem.target;
+    if (memetic)
+    {
+        options.localSearch.interval = 10;
+        options.localSearch.eliteCount = 2;
+    }
+
+    Vector solution;
+    double generations = 0;
+    double evaluations = 0;
+    double successes = 0;
+    for (auto _ : state)
+    {
+        optim.run(solution, options);
+        generations += optim.currentIteration();
+        evaluations += optim.evaluations();
+        successes += optim.stopReason() == Genocop::StopReason::TargetValue;
+        options.seed++;
+    }
+
+    state.counters["generations"] = benchmark::Counter(generations, benchmark::Counter::kAvgIterations);
+    state.counters["evaluations"] = benchmark::Counter(evaluations, benchmark::Counter::kAvgIterations);
+    state.counters["successRate"] = benchmark::Counter(successes, benchmark::Counter::kAvgIterations);
+}
+
+// =============================================
+// =================== Islands =================
+// =============================================
+
+// Time to target on the 10-D rastrigin: one population of islandCount x 100 evaluated on all threads,
+// or islandCount islands of 100 exchanging migrants (ring or random pairing)
+static void islandsBenchmark(benchmark::State & state, const bool single, const IslandModel::Topology topology)
+{
+    const uint32_t N = 10;
+    const double TARGET = 5.0; // a few local minima away from the global one
+    const uint32_t ISLANDS = std::max(2u, std::thread::hardware_concurrency());
+
+    const Vector xMin(-5.12, N);
+    const Vector xMax(5.12, N);
+
+    Genocop::Options options = benchmarkOptions();
+    options.populationCount = 100;
+    options.parentsCount = 45;
+    options.maxIters = 2000;
+
+    typedef std::chrono::steady_clock Clock;
+    double timeToTarget = 0;
+    double generations = 0;
+    double successes = 0;
+    for (auto _ : state)
+    {
+        const auto start = Clock::now();
+        double reachedAfter = -1;
+        uint32_t reachedIteration = 0;
+        Vector solution;
+
+        if (single)
+        {
+            Genocop::Options big = options;
+            big.populationCount = options.populationCount * ISLANDS;
+            big.parentsCount = options.parentsCount * ISLANDS;
+            big.threadCount = 0;
+            big.stop.targetValue = TARGET;
+
+            Genocop optim(N, rastrigin, xMin, xMax);
+            if (optim.run(solution, big) <= TARGET)
+            {
+                reachedAfter = std::chrono::duration<double>(Clock::now() - start).count();
+                reachedIteration = optim.currentIteration();
+            }
+        }
+        else
+        {
+            IslandModel::Options islandOptions;
+            islandOptions.islandCount = ISLANDS;
+            islandOptions.migrationInterval = 20;
+            islandOptions.migrantCount = 2;
+            islandOptions.topology = topology;
+            islandOptions.island = options;
+
+            IslandModel islands(N, rastrigin, xMin, xMax);
+            islands.callback = [&](uint32_t iteration, double bestValue)
+            {
+                if (reachedAfter < 0 && bestValue <= TARGET)
+                {
+                    reachedAfter = std::chrono::duration<double>(Clock::now() - start).count();
+                    reachedIteration = iteration;
+                }
+            };
+            islands.run(solution, islandOptions);
+        }
+
+        if (reachedAfter >= 0)
+        {
+            timeToTarget += reachedAfter;
+            generations += reachedIteration;
+            successes++;
+        }
+        options.seed++;
+    }
+
+    // averages over the runs that reached the target
+    state.counters["timeToTarget"] = successes > 0 ? timeToTarget / successes : -1;
+    state.counters["generations"] = successes > 0 ? generations / successes : -1;
+    state.counters["successRate"] = benchmark::Counter(successes, benchmark::Counter::kAvgIterations);
+    state.counters["islands"] = single ? 1 : ISLANDS;
+}
+
+// =============================================
+// ================ Steady state ===============
+// =============================================
+
+// 10-D rastrigin that takes 50 - 300 us depending on the position, on all threads
+static void steadyStateBenchmark(benchmark::State & state, const bool steadyState)
+{
+    const uint32_t N = 10;
+
+    auto objective = [](const Vector & x)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(50 + int(std::abs(x[0]) * 50)));
+        return rastrigin(x);
+    };
+
+    Genocop optim(N, objective, Vector(-5.12, N), Vector(5.12, N));
+
+    Genocop::Options options = benchmarkOptions();
+    options.populationCount = 100;
+    options.parentsCount = 45;
+    options.maxIters = 50;
+    options.threadCount = 0;
+
+    Vector solution;
+    double best = 0;
+    double evaluationsPerSecond = 0;
+    double workerUtilization = 0;
+    for (auto _ : state)
+    {
+        best += steadyState ? optim.runSteadyState(solution, options) : optim.run(solution, options);
+        const Genocop::Throughput throughput = optim.throughput();
+        evaluationsPerSecond += throughput.evaluationsPerSecond;
+        workerUtilization += throughput.workerUtilization;
+    }
+
+    state.counters["best"] = benchmark::Counter(best, benchmark::Counter::kAvgIterations);
+    state.counters["evaluations/s"] = benchmark::Counter(evaluationsPerSecond, benchmark::Counter::kAvgIterations);
+    state.counters["workerUtilization"] = benchmark::Counter(workerUtilization, benchmark::Counter::kAvgIterations);
+}
+
+// =============================================
+// ============ Many small problems ============
+// =============================================
+
+static std::vector<BatchSolver::Job> smallJobs()
+{
+    Genocop::Options options = benchmarkOptions();
+    options.maxIters = 100;
+    options.populationCount = 50;
+    options.parentsCount = 22;
+
+    std::vector<BatchSolver::Job> jobs;
+    for (uint32_t i = 0; i < 200; i++)
+    {
+        const uint32_t dimension = 2 + i % 19;
+        options.seed = i + 1;
+        jobs.emplace_back(rastrigin, Vector(-5.12, dimension), Vector(5.12, dimension), options);
+    }
+    return jobs;
+}
+
+static void BM_Jobs(benchmark::State & state)
+{
+    const std::vector<BatchSolver::Job> jobs = smallJobs();
+    const uint32_t threads = state.range(0);
+
+    std::unique_ptr<BatchSolver> solver;
+    if (threads > 0)
+    {
+        solver.reset(new BatchSolver(threads));
+    }
+
+    for (auto _ : state)
+    {
+        if (solver)
+        {
+            benchmark::DoNotOptimize(solver->solve(jobs));
+        }
+        else
+        {
+            Vector solution;
+            for (const auto & job : jobs)
+            {
+                Genocop optim(job.xMin.size(), job.objective, job.xMin, job.xMax);
+                benchmark::DoNotOptimize(optim.run(solution, job.options));
+            }
+        }
+    }
+
+    state.counters["jobs/s"] = benchmark::Counter(double(state.iterations()) * jobs.size(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Jobs)->ArgName("threads")->Arg(0)->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// =============================================
+// ============= Batch test functions ==========
+// =============================================
+
+static void objectiveBenchmark(benchmark::State & state, const TestFunction function)
+{
+    const uint32_t dimension = state.range(0);
+    const uint32_t population = 100;
+    const TestFunctionInfo & info = testFunctionInfo(function);
+    const BatchObjectiveFunction objective = makeTestFunction(function);
+
+    Random random(1);
+    std::vector<double> data(size_t(population) * dimension);
+    for (auto & x : data)
+        x = random.uniform(info.xMin, info.xMax);
+    std::vector<double> scores(population);
+    const PopulationMatrix matrix = {data.data(), population, dimension, dimension};
+
+    for (auto _ : state)
+    {
+        objective(matrix, scores.data());
+        benchmark::DoNotOptimize(scores.data());
+    }
+
+    state.counters["evaluations/s"] = benchmark::Counter(double(state.iterations()) * population, benchmark::Counter::kIsRate);
+    state.counters["elements/s"] = benchmark::Counter(double(state.iterations()) * population * dimension, benchmark::Counter::kIsRate);
+    state.SetLabel(testFunctionsIsa());
+}
+
+static void solveBenchmark(benchmark::State & state, const TestFunction function)
+{
+    const uint32_t dimension = state.range(0);
+    const TestFunctionInfo & info = testFunctionInfo(function);
+    Genocop optim(dimension, makeShiftedTestFunction(function, dimension, 1, false),
+                  Vector(info.xMin, dimension), Vector(info.xMax, dimension));
+
+    Genocop::Options options = benchmarkOptions();
+    options.maxIters = 200;
+
+    Vector solution;
+    double best = 0;
+    for (auto _ : state)
+    {
+        const double error = optim.run(solution, options) - info.minimum;
+        if (error < 0)
+        {
+            // the shifted function went below the minimum of its description
+            state.SkipWithError("Negative error: the value is below the stated minimum");
+            break;
+        }
+        best += error;
+    }
+
+    state.counters["error"] = benchmark::Counter(best, benchmark::Counter::kAvgIterations);
+}
+
+int main(int argc, char ** argv)
+{
+    for (const Problem & problem : PROBLEMS)
+    {
+        benchmark::RegisterBenchmark((std::string("Run/") + problem.name).c_str(), runBenchmark, problem)
+            ->Unit(benchmark::kMillisecond);
+    }
+    for (const Problem & problem : PROBLEMS)
+    {
+        benchmark::RegisterBenchmark((std::string("TimeToTarget/") + problem.name).c_str(), timeToTargetBenchmark, problem, false)
+            ->Unit(benchmark::kMillisecond);
+    }
+    for (const Problem & problem : PROBLEMS)
+    {
+        benchmark::RegisterBenchmark((std::string("TimeToTarget/memetic/") + problem.name).c_str(), timeToTargetBenchmark, problem, true)
+            ->Unit(benchmark::kMillisecond);
+    }
+
+    benchmark::RegisterBenchmark("Islands/single", islandsBenchmark, true, IslandModel::Topology::Ring)
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+    benchmark::RegisterBenchmark("Islands/ring", islandsBenchmark, false, IslandModel::Topology::Ring)
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+    benchmark::RegisterBenchmark("Islands/random", islandsBenchmark, false, IslandModel::Topology::Random)
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+    benchmark::RegisterBenchmark("SteadyState/generational", steadyStateBenchmark, false)
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+    benchmark::RegisterBenchmark("SteadyState/steadyState", steadyStateBenchmark, true)
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+    for (uint32_t i = 0; i < TEST_FUNCTION_COUNT; i++)
+    {
+        const TestFunction function = TestFunction(i);
+        benchmark::RegisterBenchmark((std::string("Objective/") + testFunctionInfo(function).name).c_str(),
+                                     objectiveBenchmark, function)
+            ->ArgName("dimension")->Arg(10)->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond);
+    }
+    for (uint32_t i = 0; i < TEST_FUNCTION_COUNT; i++)
+    {
+        const TestFunction function = TestFunction(i);
+        benchmark::RegisterBenchmark((std::string("Solve/") + testFunctionInfo(function).name).c_str(),
+                                     solveBenchmark, function)
+            ->ArgName("dimension")->Arg(10)->Arg(100)->Unit(benchmark::kMillisecond);
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
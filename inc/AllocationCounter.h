@@ -0,0 +1,12 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <stdint.h>
+
+// Linking src/AllocationCounter.cpp replaces the global operator new with one that counts calls.
+// Used to check that the optimizer's main loop does not allocate.
+
+// Number of operator new calls since program start (all threads)
+uint64_t getAllocationCount();
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef BATCH_OBJECTIVES_H
+#define BATCH_OBJECTIVES_H
+
+#include <stdint.h>
+
+#include "common.h"
+
+// Vectorized N-dimensional test functions that score whole populations (BatchObjectiveFunction),
+// for running and benchmarking the optimizer at high dimensions.
+// Like Kernels, the implementation (scalar, AVX2 or AVX-512) is chosen once at runtime and every
+// implementation gives bit-identical values: sin and cos are computed with the same polynomial
+// approximations everywhere, sqrt is correctly rounded, and exp is only called once per row, outside
+// the vectorized loops, through the same libm function. Values differ from the Objectives.h versions
+// by rounding only.
+enum class TestFunction
+{
+    Sphere,         // sum x^2
+    Ellipsoid,      // high conditioned elliptic: sum 10^(6 i / (n - 1)) x[i]^2
+    BentCigar,      // x[0]^2 + 10^6 sum x[1..]^2
+    Discus,         // 10^6 x[0]^2 + sum x[1..]^2
+    Rosenbrock,     // banana() of Objectives.h
+    Rastrigin,
+    Ackley,
+    Griewank,
+    Schwefel,       // 418.9829 n - sum x sin(sqrt(|x|)), minimum at (420.9687, ...)
+    Zakharov,
+    Himmelblau,     // himmelblau() of Objectives.h
+    Levi13,         // levi13() of Objectives.h
+    Count
+};
+
+static const uint32_t TEST_FUNCTION_COUNT = uint32_t(TestFunction::Count);
+
+struct TestFunctionInfo
+{
+    const char * name;
+    double xMin;    // usual search domain, the same for every element
+    double xMax;
+    double minimum; // global minimum value (without the shift bias)
+};
+
+const TestFunctionInfo & testFunctionInfo(const TestFunction function);
+
+// Batch version of a test function
+BatchObjectiveFunction makeTestFunction(const TestFunction function);
+
+// CEC-style variant f(M (x - o)) + bias: the optimum is moved to a random o inside 80% of the domain and,
+// if rotate is set, the coordinates are mixed by a random orthogonal matrix M so that the function is
+// no longer separable. Rotation costs O(n^2) memory and time per evaluation.
+// The same seed gives the same shift and rotation. Thread safe.
+BatchObjectiveFunction makeShiftedTestFunction(const TestFunction function, const uint32_t dimension,
+                                               const uint64_t seed, const bool rotate, const double bias = 0);
+
+// Name of the selected instruction set
+const char * testFunctionsIsa();
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef BATCH_SOLVER_H
+#define BATCH_SOLVER_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <memory>
+#include <stdint.h>
+
+#include "common.h"
+#include "Genocop.h"
+
+// Solves many small independent problems in parallel, one job per thread at a time.
+// Every worker owns a Genocop that is reused for all of its jobs (setProblem), so after the first
+// few jobs running a new one doesn't allocate unless it is larger than the previous ones.
+// Jobs are queued per worker; a worker that runs out of jobs steals from the others, so long and
+// short jobs are balanced without a central queue. Results are returned as soon as each job finishes.
+// Each job runs on a single thread (options.threadCount is ignored), so a job with a fixed seed gives the
+// same result whatever the number of threads and the order of the jobs.
+// The objective of a job is only called from the thread running it.
+class BatchSolver
+{
+public:
+    struct Job
+    {
+        BatchObjectiveFunction objective;
+        Vector xMin;
+        Vector xMax;
+        Genocop::Options options;
+
+        Job()
+        {
+        }
+
+        Job(ObjectiveFunction objective, const Vector & xMin, const Vector & xMax, const Genocop::Options & options) :
+            objective(makeBatchObjective(objective)), xMin(xMin), xMax(xMax), options(options)
+        {
+        }
+
+        Job(BatchObjectiveFunction objective, const Vector & xMin, const Vector & xMax, const Genocop::Options & options) :
+            objective(objective), xMin(xMin), xMax(xMax), options(options)
+        {
+        }
+    };
+
+    struct Result
+    {
+        uint64_t id = 0;         // returned by submit()
+        double value = 1e+99;    // best value
+        Vector solution;
+        Genocop::Stats stats;    // stats.stopReason is Cancelled for jobs cancelled before they started
+        std::exception_ptr error; // set if the job threw (e.g. invalid options or an objective error)
+    };
+
+    // Called on the worker thread as soon as a job finishes. If set, results are not kept for next()
+    typedef std::function<void(Result & result)> ResultCallback;
+
+    ResultCallback callback = 0;
+
+    // threadCount = 0 -> use all hardware threads
+    explicit BatchSolver(uint32_t threadCount = 0);
+
+    // Cancels the jobs that are still queued and waits for the running ones
+    ~BatchSolver();
+
+    BatchSolver(const BatchSolver &) = delete;
+    BatchSolver & operator=(const BatchSolver &) = delete;
+
+    uint32_t size() const
+    {
+        return uint32_t(workers.size());
+    }
+
+    // Queue a job. Ids are consecutive, starting at 0. Can be called from any thread, also while jobs run
+    uint64_t submit(Job job);
+
+    // Wait for the next finished job (in order of completion).
+    // Returns false if every submitted job has already been returned (or given to the callback)
+    bool next(Result & outResult);
+
+    // Wait until every submitted job is finished
+    void wait();
+
+    // Solve the jobs and return the results in the order of the jobs.
+    // Throws if results of earlier submit() calls haven't been returned by next() yet.
+    // Must not be mixed with submit() calls from other threads
+    std::vector<Result> solve(std::vector<Job> jobs);
+
+    // Stop every job submitted so far: queued jobs are not started, running jobs stop after their
+    // current generation (unless their options have their own stop.cancel flag). Jobs submitted later run normally
+    void cancel();
+
+private:
+    struct QueuedJob
+    {
+        uint64_t id;
+        Job job;
+    };
+
+    // State of one worker. Its queued jobs: the owner takes from the back, thieves from the front
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<QueuedJob> jobs;
+
+        // id of the running job and the cancel flag given to it
+        std::atomic<uint64_t> runningId;
+        std::atomic<bool> cancel;
+
+        // created by the first job, reused by the next ones
+        std::unique_ptr<Genocop> optimizer;
+
+        Worker() : runningId(UINT64_MAX), cancel(false)
+        {
+        }
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Worker>> states;
+
+    std::mutex mutex;
+    std::condition_variable workCondition;   // a job was queued (or stopping)
+    std::condition_variable resultCondition; // a job finished
+    uint64_t submitted = 0;  // jobs submitted so far (= next id)
+    uint64_t finished = 0;   // jobs finished so far
+    uint64_t returned = 0;   // results returned by next() or given to the callback
+    uint64_t queued = 0;     // jobs waiting in any queue
+    bool stopping = false;
+    std::deque<Result> results; // finished, not yet returned by next()
+
+    // jobs with smaller ids than this are cancelled
+    std::atomic<uint64_t> cancelBefore;
+    // worker that gets the next submitted job
+    uint32_t nextWorker = 0;
+
+    void workerLoop(const uint32_t workerIdx);
+
+    // Take a job from the own queue or steal one
+    bool takeJob(const uint32_t workerIdx, QueuedJob & outJob);
+
+    void runJob(const uint32_t workerIdx, QueuedJob & queued, Result & outResult);
+
+    void finishJob(Result & result);
+};
+
+#endif
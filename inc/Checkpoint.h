@@ -0,0 +1,170 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Snapshot of a Genocop run, see Genocop::checkpoint and Genocop::resume.
+// File layout, native byte order, every section starts at a multiple of 64 bytes so that the doubles
+// of a memory-mapped file can be used in place:
+//   CheckpointHeader | Genocop::Options | scores[populationCount] | best solution[vectorSize] |
+//   population[populationCount][vectorSize]
+// The options are stored as raw bytes, so a checkpoint can only be resumed by the same build of the library.
+struct CheckpointHeader
+{
+    char magic[8];            // CHECKPOINT_MAGIC
+    uint32_t version;         // CHECKPOINT_VERSION
+    uint32_t optionsSize;     // sizeof(Genocop::Options) of the writer
+
+    uint32_t vectorSize;
+    uint32_t populationCount;
+
+    // run state after generation `iteration`
+    uint32_t iteration;
+    uint32_t stallIteration;
+    uint64_t seed;            // the random streams only depend on the seed and the generation
+    uint64_t evaluations;
+    double bestValue;
+    double stallBest;
+    double elapsedSeconds;
+
+    // byte offsets of the sections and size of the whole file
+    uint64_t optionsOffset;
+    uint64_t scoresOffset;
+    uint64_t bestOffset;
+    uint64_t populationOffset;
+    uint64_t fileSize;
+};
+
+static const char CHECKPOINT_MAGIC[8] = {'G', 'E', 'N', 'O', 'C', 'K', 'P', 'T'};
+static const uint32_t CHECKPOINT_VERSION = 1;
+
+// Set the magic, version and section offsets of a header whose sizes are filled in
+void checkpointLayout(CheckpointHeader & header);
+
+// Writes snapshots on a background thread, so the generation loop only pays for copying the state.
+// The optimizer fills buffer() and submit()s it; the thread writes it to filename + ".tmp" and renames
+// that to filename, so the file always holds a complete snapshot, even if the process dies while writing.
+// A snapshot submitted while the previous one is still waiting replaces it.
+// One producer: a writer can be shared by several optimizers only if they run one after another.
+class CheckpointWriter
+{
+public:
+    // A snapshot every interval generations (counted from the start of the run)
+    CheckpointWriter(const std::string & filename, const uint32_t interval);
+
+    // Writes the waiting snapshot
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter &) = delete;
+    CheckpointWriter & operator=(const CheckpointWriter &) = delete;
+
+    uint32_t interval() const
+    {
+        return every;
+    }
+
+    const std::string & filename() const
+    {
+        return path;
+    }
+
+    // Buffer for the next snapshot, owned by the producer until submit(). Keeps its memory between snapshots
+    std::vector<char> & buffer()
+    {
+        return front;
+    }
+
+    void submit();
+
+    // Block until every submitted snapshot is written (or replaced)
+    void flush();
+
+    // Snapshots written, replaced by a newer one before they were written, and failed (I/O errors)
+    uint64_t written() const
+    {
+        return writtenCount.load(std::memory_order_relaxed);
+    }
+
+    uint64_t replaced() const
+    {
+        return replacedCount.load(std::memory_order_relaxed);
+    }
+
+    uint64_t failed() const
+    {
+        return failedCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    const std::string path;
+    const uint32_t every;
+
+    // front: filled by the producer, pending: submitted, back: being written
+    std::vector<char> front;
+    std::vector<char> pending;
+    std::vector<char> back;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool hasPending = false;
+    bool writing = false;
+    bool stopping = false;
+
+    std::atomic<uint64_t> writtenCount{0};
+    std::atomic<uint64_t> replacedCount{0};
+    std::atomic<uint64_t> failedCount{0};
+    std::thread writerThread;
+
+    void writerLoop();
+    bool write(const std::vector<char> & data);
+};
+
+// Read-only, memory-mapped checkpoint file.
+// Throws if the file can't be opened or isn't a complete checkpoint of this version
+class CheckpointFile
+{
+public:
+    explicit CheckpointFile(const std::string & filename);
+    ~CheckpointFile();
+
+    CheckpointFile(const CheckpointFile &) = delete;
+    CheckpointFile & operator=(const CheckpointFile &) = delete;
+
+    const CheckpointHeader & header() const
+    {
+        return *reinterpret_cast<const CheckpointHeader *>(data);
+    }
+
+    const void * options() const
+    {
+        return data + header().optionsOffset;
+    }
+
+    const double * scores() const
+    {
+        return reinterpret_cast<const double *>(data + header().scoresOffset);
+    }
+
+    const double * bestSolution() const
+    {
+        return reinterpret_cast<const double *>(data + header().bestOffset);
+    }
+
+    const double * row(const uint32_t i) const
+    {
+        return reinterpret_cast<const double *>(data + header().populationOffset) + size_t(i) * header().vectorSize;
+    }
+
+private:
+    const char * data = nullptr;
+    size_t size = 0;
+};
+
+#endif
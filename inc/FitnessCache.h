@@ -0,0 +1,75 @@
+#ifndef FITNESS_CACHE_H
+#define FITNESS_CACHE_H
+
+#include <vector>
+#include <stdint.h>
+
+// Bounded map genome -> objective value, used to skip evaluating exact copies of individuals
+// (elite children, copied parents). Genomes are compared bit by bit.
+//
+// The cache is set associative: a genome can only be stored in one set of WAYS entries (chosen by its hash),
+// and when that set is full its least recently used entry is evicted.
+// Memory: capacity * (vectorSize + 3) doubles, allocated by configure() - lookups and inserts don't allocate.
+// Not thread safe.
+class FitnessCache
+{
+public:
+    static const uint32_t WAYS = 4;
+
+    struct Stats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t insertions = 0;
+        uint64_t evictions = 0;
+
+        double hitRate() const
+        {
+            const uint64_t total = hits + misses;
+            return total > 0 ? double(hits) / total : 0.0;
+        }
+    };
+
+    // Allocate space for at least capacity genomes (rounded up) of vectorSize elements. Clears the cache
+    void configure(const uint32_t capacity, const uint32_t vectorSize);
+
+    // Remove all entries and reset the statistics
+    void clear();
+
+    // Number of genomes that can be stored
+    uint32_t capacity() const
+    {
+        return setCount * WAYS;
+    }
+
+    // If the genome is cached, write its value to outValue and return true
+    bool lookup(const double * genome, double & outValue);
+
+    // Store a genome's value, evicting the least recently used entry of its set if needed
+    void insert(const double * genome, const double value);
+
+    const Stats & stats() const
+    {
+        return statistics;
+    }
+
+private:
+    uint32_t setCount = 0; // power of 2
+    uint32_t vectorSize = 0;
+
+    // per entry: set * WAYS + way
+    std::vector<uint64_t> hashes;
+    std::vector<uint64_t> lastUse; // 0 -> empty entry
+    std::vector<double> values;
+    std::vector<double> genomes;   // vectorSize doubles per entry
+
+    uint64_t clock = 0;
+    Stats statistics;
+
+    uint64_t hash(const double * genome) const;
+
+    // Entry index with the given genome or -1
+    int64_t find(const double * genome, const uint64_t h) const;
+};
+
+#endif
@@ -3,12 +3,25 @@
 
 #include <valarray>
 #include <functional>
+#include <atomic>
 #include <vector>
-#include <random>
 #include <chrono>
+#include <memory>
 #include <stdint.h>
 
 #include "common.h"
+#include "Checkpoint.h"
+#include "FitnessCache.h"
+#include "GenomeMatrix.h"
+#include "Kernels.h"
+#include "LinearConstraints.h"
+#include "LocalSearch.h"
+#include "ParentSelector.h"
+#include "Profile.h"
+#include "Random.h"
+#include "Sobol.h"
+#include "Telemetry.h"
+#include "ThreadPool.h"
 
 class Genocop
 {
@@ -25,21 +38,64 @@ public:
         }
     };    
 
+    // How the first population is sampled (apart from the seeds, see setSeeds)
+    enum class Initialization
+    {
+        Uniform,        // independent uniform values
+        LatinHypercube, // every gene takes each of populationCount equal slices of its range exactly once
+        Sobol           // quasi-random points of the Sobol sequence, randomized by the seed
+    };
+
     struct Options
     {
         uint32_t populationCount = 100;
         uint32_t parentsCount = 45;
         uint32_t maxIters = 1000;
 
+        // Number of threads used to evaluate the objective function and create children (0 -> all hardware threads).
+        // With more than one thread the objective function must be safe to call concurrently.
+        // Results do not depend on the thread count.
+        uint32_t threadCount = 1;
+
+        // Runs with the same seed and options give identical results. 0 -> seed from the system clock
+        uint64_t seed = 0;
+
+        // =============================================
+        // ============= Initial population ============
+        // =============================================
+
+        struct
+        {
+            Initialization method = Initialization::Uniform;
+            // With seeds: up to this fraction of the population is made of copies of the seeds
+            double seedFraction = 0.5;
+            // Every copy of a seed after the first one gets gaussian noise with this standard deviation
+            // (relative to xMax - xMin). 0 -> exact copies
+            double perturbation = 0.01;
+        } init;
+
         // =============================================
         // ================= Selection =================
         // =============================================
+        ParentSelector::Method selection = ParentSelector::Method::Tournament;
+
         struct
         {   
             int size = 4; // larger size -> larger selection pressure
             double p = 0.9; // probability that the best in the tournament wins. Set to 1 for 100% deterministic tournament
         } tournament;
 
+        // LinearRanking and StochasticUniversal
+        struct
+        {
+            double pressure = 1.5; // expected copies of the best individual: 1 (uniform) to 2
+        } ranking;
+
+        struct
+        {
+            double fraction = 0.3; // only the best fraction of the population can be selected
+        } truncation;
+
         // =============================================
         // ============= Genetic operators =============
         // =============================================
@@ -64,31 +120,304 @@ public:
             double fineMutationMin = 1e-5;
             double fineMutationMax = 0.15;
         } mutatation;
+
+        // =============================================
+        // ================ Local search ===============
+        // =============================================
+
+        // Memetic stage: Nelder-Mead refines the best individuals, which are replaced by the refined points.
+        // Its evaluations count like the others (evaluations(), stop.maxEvaluations).
+        // Works best on smooth objectives, where it replaces dozens of generations of fine mutations
+        struct
+        {
+            uint32_t interval = 0;          // refine every interval generations, 0 -> never
+            uint32_t eliteCount = 1;        // distinct individuals refined each time (in parallel with several threads)
+            uint32_t maxEvaluations = 0;    // per individual, 0 -> 20 * (vectorSize + 1). Within stop.maxEvaluations
+            double initialStep = 0.01;      // size of the initial simplex relative to xMax - xMin. The memetic stage
+                                            // uses the spread of the best individuals instead when it is smaller
+            uint32_t polishEvaluations = 0; // refine the best solution at the end of run() with this budget, 0 -> no polish.
+                                            // Within stop.maxEvaluations; skipped after Cancelled and TimeLimit
+        } localSearch;
+
+        // =============================================
+        // ================ Fitness cache ==============
+        // =============================================
+
+        // Remember the values of recently evaluated genomes, so that exact copies (elite children,
+        // copied parents) are not evaluated again. Only worth it for expensive, deterministic objectives.
+        // Uses about capacity * (vectorSize + 3) * 8 bytes
+        struct
+        {
+            uint32_t capacity = 0; // genomes to remember, 0 -> no cache
+        } cache;
+
+        // =============================================
+        // ============= Stopping criteria =============
+        // =============================================
+
+        // run() stops after maxIters generations or as soon as one of these is met.
+        // Checked between generations; every criterion is off by default
+        struct
+        {
+            double targetValue = -1e+99;   // the best value is <= targetValue
+            uint32_t stallGenerations = 0; // no improvement larger than stallTolerance for this many generations
+            double stallTolerance = 0;
+            double minDiversity = 0;       // mean standard deviation of the genes (relative to xMax - xMin) is below
+            double maxSeconds = 0;         // wall-clock time since start()
+            uint64_t maxEvaluations = 0;   // the next generation could exceed this many evaluations
+
+            // Set to true from any thread to stop after the current generation
+            const std::atomic<bool> * cancel = nullptr;
+        } stop;
+    };
+
+    // Why the last run stopped
+    enum class StopReason
+    {
+        None,             // still running
+        MaxIterations,
+        TargetValue,
+        Stalled,
+        Converged,        // population diversity fell below minDiversity
+        TimeLimit,
+        EvaluationLimit,
+        Cancelled
     };
 
+    // Copy of the whole population after every generation. Observers (subscribe) see it without copying
     typedef std::function<void(const std::vector<Score> &)> IterationCallback;
     
     IterationCallback callback = 0;
 
+    // Non-owning view of the current population, only valid during the observer call
+    struct PopulationView
+    {
+        PopulationMatrix genomes;     // one row per individual
+        const double * scores;        // objective values of the rows
+        uint32_t iteration;
+        double bestValue;             // since start()
+        const double * bestSolution;
+        bool improved;                // bestValue improved since the previous generation
+
+        uint32_t size() const
+        {
+            return genomes.rows;
+        }
+    };
+
+    typedef std::function<void(const PopulationView &)> PopulationObserver;
+
+    // Generations an observer is called for: every-th ones and/or the ones that improve the best value
+    struct Subscription
+    {
+        uint32_t every = 1;         // 0 -> only on improvement
+        bool onImprovement = false;
+    };
+
+    // Optional per-generation statistics (not owned). Collecting them costs a few clock reads per child
+    TelemetryWriter * telemetry = nullptr;
+
+    // Optional snapshots of run() every checkpoint->interval() generations (not owned), see resume().
+    // Taking one copies the population into the writer's buffer; the file is written on the writer's thread
+    CheckpointWriter * checkpoint = nullptr;
+
     Genocop(const uint32_t vectorSize, ObjectiveFunction objective, 
             const Vector xMin, const Vector xMax);
 
+    // The objective scores whole populations (or, with several threads, contiguous parts of one)
+    Genocop(const uint32_t vectorSize, BatchObjectiveFunction objective, 
+            const Vector xMin, const Vector xMax);
+
+    // Optimize a different problem from now on. Keeps the population buffers and the thread pool,
+    // so a reused optimizer only allocates when the problem grows
+    void setProblem(const uint32_t vectorSize, BatchObjectiveFunction objective,
+                    const Vector & xMin, const Vector & xMax);
+
+    // Warm start: the first population of the following runs starts with copies of these solutions
+    // (e.g. the results of previous runs or a saved population, best first), see options.init.
+    // Seeds outside of [xMin, xMax] are clamped. They stay until clearSeeds() or the next setSeeds()
+    void setSeeds(const std::vector<Vector> & solutions);
+    void setSeeds(const GenomeMatrix & rows);
+
+    void clearSeeds();
+
+    // Call the observer after every scored generation (the first population included). Generations it skips cost nothing.
+    // Returns an id for unsubscribe(). Observers are called in subscription order, after the callback
+    uint32_t subscribe(PopulationObserver observer);
+    uint32_t subscribe(PopulationObserver observer, const Subscription & subscription);
+
+    // Not from inside an observer
+    void unsubscribe(const uint32_t id);
+
+    // Linear equalities and inequalities on top of the box bounds (GENOCOP style, see LinearConstraints).
+    // Every individual of the following runs satisfies them and the objective is only called on feasible points:
+    // children are completed and moved back towards a feasible parent, the local search works on the free variables.
+    // Throws if the constraints are inconsistent or no feasible point is found. setProblem() clears them
+    void setConstraints(const LinearConstraints & constraints);
+
+    void clearConstraints();
+
     double run(Vector & outSolution, Genocop::Options options);
+
+    // Continue a run from a checkpoint file written by run() on the same problem (same vector size).
+    // Continues with the options of the checkpoint and gives the same result as the uninterrupted run.
+    // stop.cancel isn't saved and can be given here. The fitness cache restarts empty.
+    // Constraints aren't saved either: set the same ones before resuming
+    double resume(const std::string & filename, Vector & outSolution, const std::atomic<bool> * cancel = nullptr);
+
+    // Summary of a run. The profile is only filled when compiled with GENOCOP_PROFILE
+    struct Stats
+    {
+        uint32_t iterations = 0;
+        uint64_t evaluations = 0;
+        double seconds = 0;
+        StopReason stopReason = StopReason::None;
+
+        bool profiled = false;
+        PhaseStats total[PROFILE_PHASE_COUNT];          // whole run, indexed by ProfilePhase
+        PhaseStats lastGeneration[PROFILE_PHASE_COUNT];
+    };
+
+    // run() that also returns the statistics of the run
+    double run(Vector & outSolution, Genocop::Options options, Stats & outStats);
+
+    // Statistics since start()
+    Stats stats() const;
+
+    // =============================================
+    // ============ Step-by-step control ===========
+    // =============================================
+    // run() = start() + step() until maxIters. Drivers such as IslandModel use these directly
+
+    // Create and score the first population
+    void start(Genocop::Options options);
+
+    // Load the state of a checkpoint instead of creating a first population; step() continues the run
+    void restore(const std::string & filename, const std::atomic<bool> * cancel = nullptr);
+
+    // Evolve one generation and score it
+    void step();
+
+    // Generations evolved since start()
+    uint32_t currentIteration() const
+    {
+        return iteration;
+    }
+
+    // Best value and solution found since start()
+    double bestValue() const
+    {
+        return bestScore;
+    }
+
+    const Vector & bestVector() const
+    {
+        return bestSolution;
+    }
+
+    // Number of objective function evaluations since start()
+    uint64_t evaluations() const
+    {
+        return evaluationCount;
+    }
+
+    // Check the stopping criteria of the current run (maxIters included). Also sets stopReason()
+    StopReason checkStop();
+
+    StopReason stopReason() const
+    {
+        return stopCause;
+    }
+
+    // Mean standard deviation of the genes relative to xMax - xMin, 0 = all individuals are equal.
+    // Only computed when options.stop.minDiversity > 0 or with telemetry
+    double populationDiversity() const
+    {
+        return diversity;
+    }
+
+    // Hit/miss statistics of the fitness cache since start()
+    const FitnessCache::Stats & cacheStats() const
+    {
+        return fitnessCache.stats();
+    }
+
+    // Copy the count best individuals of the current population (best first)
+    void getBest(const uint32_t count, GenomeMatrix & outRows, std::vector<double> & outValues);
+
+    // Replace the worst individuals of the current population with already scored ones
+    void replaceWorst(const GenomeMatrix & rows, const std::vector<double> & values);
+
+    // Asynchronous steady-state evolution: after the first population is scored, every worker thread
+    // repeatedly creates one child (selection + crossover + mutation) from the current population,
+    // evaluates it and inserts it in place of the worst individual if it is better.
+    // Workers never wait for each other, which helps when evaluation times vary a lot.
+    // Runs (maxIters + 1) * populationCount evaluations like run(); every populationCount evaluations
+    // count as a generation for the callback and the stopping criteria. StochasticUniversal selection is replaced by LinearRanking
+    // and the fitness cache is not used. With more than one thread the result depends on timing.
+    double runSteadyState(Vector & outSolution, Genocop::Options options);
+
+    // Evaluation throughput since start()
+    struct Throughput
+    {
+        uint64_t evaluations = 0;
+        double seconds = 0;
+        double evaluationsPerSecond = 0;
+        double workerUtilization = 0; // fraction of the workers' time spent in the objective function
+    };
+
+    Throughput throughput() const;
+
+    // Seed used by the last run (useful to reproduce runs seeded from the clock)
+    uint64_t lastSeed() const
+    {
+        return runSeed;
+    }
     
 private:
     
-    ObjectiveFunction objFunction;
-    const size_t vectorSize;
+    BatchObjectiveFunction objFunction;
+    size_t vectorSize;
+
+    // Workers for parallel evaluation - kept between iterations and runs
+    std::unique_ptr<ThreadPool> threadPool;
+    // threadPool if the current run is parallel, null otherwise
+    ThreadPool * activePool = nullptr;
+
+    // Run body(begin, end, threadIdx) over [0, count) on the active pool or on the calling thread
+    template <class Body>
+    void parallelFor(const uint32_t count, const Body & body, const uint32_t grainSize = 0)
+    {
+        if (activePool != nullptr)
+        {
+            activePool->parallelFor(count, body, grainSize);
+        }
+        else
+        {
+            body(0, count, 0);
+        }
+    }
 
     // =============================================
     // ========== Random value generators ==========
     // =============================================
+    // Every generation and every individual has its own stream: Random::stream(runSeed, iteration, STREAM_* | index)
+    // so results don't depend on the order in which individuals are processed
 
-    std::default_random_engine randomEngine;
-    std::uniform_real_distribution<double> pRng;  // probability: [0, 1]
-    std::uniform_real_distribution<double> mRng;  // mutation: [-1, 1]
-    std::uniform_int_distribution<uint32_t> cRng; // crossover index: [1, vectorSize - 1]
-    std::normal_distribution<double> dRng;        // for direction generation
+    static const uint64_t STREAM_INIT = 0;             // first population, one stream per individual
+    static const uint64_t STREAM_SELECT = 1ull << 32;  // one stream per parent
+    static const uint64_t STREAM_PLAN = 2ull << 32;    // crossover plan, one stream per generation
+    static const uint64_t STREAM_CHILD = 3ull << 32;   // one stream per child
+    static const uint64_t STREAM_STEADY = 4ull << 32;  // steady state: one stream per child (child number is the first counter)
+    static const uint64_t STREAM_GENE = 5ull << 32;    // Latin hypercube and Sobol initialization, one stream per gene
+    static const uint64_t STREAM_REPAIR = 6ull << 32;  // constraints: first population, one stream per individual
+
+    uint64_t runSeed = 0;
+
+    Random getStream(const uint32_t iter, const uint64_t stream, const uint32_t idx) const
+    {
+        return Random::stream(runSeed, iter, stream | idx);
+    }
 
     Vector xMin;
     Vector xMax;
@@ -98,67 +427,238 @@ private:
     Vector offsetX;
     Vector scaleX; 
 
-    // used by selectParents and create children - avoid allocation every time
-    std::vector<uint32_t> scoreIdx;
+    // vectorized loops for the operators
+    const Kernels & kernels;
+
+    // =============================================
+    // ============== Population state =============
+    // =============================================
+    // Kept between runs so that memory is only allocated when the problem grows
+
+    GenomeMatrix population; // current generation
+    GenomeMatrix children;   // next generation, swapped with population after each iteration
+    std::vector<double> scores;    // objective values of the population rows
+    std::vector<uint32_t> parents; // population rows selected for reproduction
+
+    // ranks the population for selection and elitism
+    ParentSelector selector;
+
+    // linear constraints (setConstraints), empty -> only the box
+    LinearConstraints constraints;
+
+    // warm start solutions (setSeeds)
+    GenomeMatrix seedRows;
+    // kept for the next runs, the direction numbers of high dimensions take a while to compute
+    std::unique_ptr<SobolSequence> sobol;
+
+    // state of the current run
+    Options runOptions;  // validated options
+    uint32_t iteration = 0;
+    double bestScore = 1e+99;
+    Vector bestSolution;
+    double averageScore = 0;
+
+    uint64_t evaluationCount = 0;
+
+    // stopping criteria
+    StopReason stopCause = StopReason::None;
+    double stallBest = 1e+99;         // best value at the last significant improvement
+    uint32_t stallIteration = 0;      // ... and its generation
+    double diversity = 0;
+    Vector geneMean;                  // scratch for updateDiversity
+    Vector geneVariance;
+
+    // for throughput()
+    std::chrono::steady_clock::time_point runStart;
+    std::vector<uint64_t> busyNanoseconds; // time spent in the objective, per thread
+
+    // operator counts and times of one thread, only collected with telemetry
+    struct OperatorCounters
+    {
+        uint32_t children[5];   // by ChildPlan::Type
+        uint32_t fineMutations;
+        uint32_t fullMutations;
+        uint64_t crossoverNs;
+        uint64_t mutationNs;
+        char padding[16];       // one cache line per thread
+
+        void clear()
+        {
+            *this = OperatorCounters();
+        }
+    };
+    std::vector<OperatorCounters> counters;
+    double selectionSeconds = 0;     // of the current generation
+    uint64_t busyAtLastRecord = 0;   // sum of busyNanoseconds when the last record was pushed
+
+    // GENOCOP_PROFILE: per thread counters, merged after every generation
+    std::vector<ProfileCounters> profileCounters;
+    PhaseStats profileTotal[PROFILE_PHASE_COUNT];
+    PhaseStats profileLastGeneration[PROFILE_PHASE_COUNT];
+
+    // only filled if there is a callback
+    std::vector<Score> callbackScores;
+
+    struct Observer
+    {
+        uint32_t id;
+        PopulationObserver function;
+        Subscription subscription;
+    };
+    std::vector<Observer> observers;
+    uint32_t nextObserverId = 0;
+    double notifiedBest = 1e+99; // best value at the previous notification, for PopulationView::improved
+
+    // values of already evaluated genomes (if enabled by options)
+    FitnessCache fitnessCache;
+    std::vector<uint32_t> missIdx; // population rows not found in the cache
+    GenomeMatrix missRows;         // their genomes, evaluated together
+    std::vector<double> missScores;
+
+    // used by getBest and replaceWorst
+    std::vector<uint32_t> sortScratch;
+
+    // local search: one optimizer per thread, initial simplex steps, refined rows and their evaluations
+    struct LocalSearcher
+    {
+        NelderMead nelderMead;
+        // with constraints: the start, bounds and steps of the free variables
+        Vector x;
+        Vector xMin;
+        Vector xMax;
+        Vector step;
+        // the feasible trial points completed to full genomes, and their values
+        GenomeMatrix expanded;
+        std::vector<uint32_t> feasibleRows;
+        std::vector<double> feasibleScores;
+    };
+    std::vector<LocalSearcher> localSearchers;
+    Vector localSearchStep;
+    std::vector<uint32_t> refineRows;
+    std::vector<uint32_t> refineEvaluations;
+
+    // Validate the options and reset the state for a new run (everything except the population)
+    void initRun(Genocop::Options options);
+
+    // Snapshot for the checkpoint writer if it's due this generation
+    void saveCheckpoint();
+
+    // Fill the first population: seeds, then options.init.method
+    void initialPopulation();
+
+    // Memetic stage: run the local search from the best distinct individuals of the population
+    void refineElites();
+
+    // Final local search from the best solution
+    void polishBest();
+
+    // Nelder-Mead from x (of known value) on the given thread, in the free variables if there are constraints.
+    // Returns the number of objective evaluations
+    uint32_t localMinimize(const uint32_t threadIdx, double * x, double & value, const double * step,
+                           const uint32_t maxEvaluations);
+
+    // Make x (inside the box) satisfy the constraints: complete it and, if it's still infeasible, move it
+    // towards the feasible point - to the boundary, or with randomStep to a random point of the feasible part
+    void repair(double * x, const double * feasible, const bool randomStep, Random & rng) const;
+
+    // Initial simplex steps of the memetic stage from the spread of the best individuals
+    void updateLocalSearchStep();
+
+    // Score the current population, update the best solution and call the callback
+    void calculateScores();
+
+    // Evaluate the population rows that are not in the fitness cache
+    void calculateScoresCached();
+
+    // Call the objective function and count the time as busy for the thread
+    void evaluate(const PopulationMatrix & rows, double * outScores, const uint32_t threadIdx);
+
+    // Track improvements for the stall criterion and compute the diversity if it's needed
+    void updateProgress();
+
+    // Pass the current population to the callback and the observers that subscribed to this generation
+    void notifyCallback();
+
+    // Push the statistics of the current generation to the telemetry and reset the counters
+    void recordGeneration();
+
+    // Add the per thread profile counters to the totals
+    void collectProfile();
+
+    // Steady state: select parents and create one mutated child
+    void createSteadyChild(const uint64_t childNumber, double * outChild, double * direction,
+                           const uint32_t threadIdx);
+
+    static ParentSelector::Settings selectorSettings(const Genocop::Options & options);
+
+    // How a child is created - decided serially by createChildren, then executed in parallel
+    struct ChildPlan
+    {
+        enum Type : uint8_t
+        {
+            Elite,          // copy of parent0, no mutation
+            Copy,           // copy of parent0
+            Classic,        // parent0[0..crossIdx) + parent1[crossIdx..)
+            Linear,         
+            Heuristic
+        } type;
+
+        uint32_t parent0; // population rows
+        uint32_t parent1;
+        uint32_t crossIdx;
+        double alpha;
+    };
+    std::vector<ChildPlan> plan;
+
+    // scratch space for fineRangeMutation, one per thread
+    std::vector<Vector> directions;
 
     // Selects outParents.size() individuals from scores (with possible repetition) based on values
-    // using tournaments
-    // - tournamentSize: how many individuals to participate in the tournament. Higher values => more selection pressure
-    // - tournamentP: probability that the best individual wins a tournament
-    void selectParents(const std::vector<Score> & scores, std::vector<Score> & outParents,
-                       const uint32_t tournamentSize, const double tournamentP);
+    // using options.selection. Also ranks the population for createChildren
+    void selectParents(const std::vector<double> & scores, std::vector<uint32_t> & outParents,
+                       const Genocop::Options & options, const uint32_t iter);
 
     // Create children from parents using:
     // - elitism: copy the best parents directly into the output
     // - crossovers
     // - direct copying (if crossovers do not produce enough children)
     //
-    // For each child that is not elite, run a mutation check
-    void createChildren(const std::vector<Score> & scores, std::vector<Score> & parents,
-                        std::vector<Vector> & outChildren, const Genocop::Options & options,
-                        const uint32_t iter);
+    // For each child that is not elite, run a mutation check.
+    // Children are planned serially and created in parallel
+    void createChildren(const GenomeMatrix & population, const std::vector<double> & scores,
+                        const std::vector<uint32_t> & parents, GenomeMatrix & outChildren,
+                        const Genocop::Options & options, const uint32_t iter);
+
+    // Create the child in the given row according to the plan and mutate it
+    void executePlan(const GenomeMatrix & population, const std::vector<double> & scores,
+                     const ChildPlan & childPlan, double * outChild,
+                     const Genocop::Options & options, const double fineMutationRange,
+                     Random & rng, double * direction, const uint32_t threadIdx);
 
     // =============================================
     // ============= Genetic operators =============
     // =============================================
+    // Genomes are rows of vectorSize elements
 
-    void classicCrossover(const Score & parent0, const Score & parent1,
-                          Vector & outChild0, Vector & outChild1);
+    // parent0[0..crossIdx) + parent1[crossIdx..vectorSize)
+    void classicCrossover(const double * parent0, const double * parent1, const uint32_t crossIdx,
+                          double * outChild);
 
-    void linearCrossover(const Score & parent0, const Score & parent1, double alpha,
-                         Vector & outChild);
+    void linearCrossover(const double * parent0, const double * parent1, double alpha,
+                         double * outChild);
 
     // Linear crossover in the direction worse -> better    
-    void heuristicCrossover(const Score & parent0, const Score & parent1, double alpha,
-                            Vector & outChild);
-
-    void fullRangeMutation(Vector & x, const double pFull);
+    void heuristicCrossover(const double * parent0, const double value0,
+                            const double * parent1, const double value1,
+                            double alpha, double * outChild);
 
-    void fineRangeMutation(Vector & x, const double range);
+    void fullRangeMutation(double * x, Random & rng);
 
-    // =============================================
-    // =============== RNG functions ===============
-    // =============================================
-
-    // [0, 1]
-    inline double getProbability()
-    {
-        return this->pRng(this->randomEngine);
-    }
-
-    // [-1, 1]
-    inline double getMutation()
-    {
-        return this->mRng(this->randomEngine);
-    }
-
-    // [1, vectorSize - 1]
-    inline uint32_t getCrossoverIdx()
-    {
-        return this->cRng(this->randomEngine);
-    }
+    // direction: scratch space of vectorSize elements
+    void fineRangeMutation(double * x, const double range, Random & rng, double * direction);
 
-    inline void getRandomDirection(Vector & dir);
+    // Random unit vector of vectorSize elements
+    void getRandomDirection(double * dir, Random & rng);
 };
 
 #endif
\ No newline at end of file
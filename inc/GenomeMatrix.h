@@ -0,0 +1,81 @@
+#ifndef GENOME_MATRIX_H
+#define GENOME_MATRIX_H
+
+#include <memory>
+#include <stdint.h>
+
+#include "common.h"
+
+// Row-major storage for a population: one genome per row.
+// The block and every row start on a cache line boundary. Memory is only reallocated
+// when a resize needs more than the current capacity, so a matrix can be reused across runs.
+class GenomeMatrix
+{
+public:
+    // row alignment in doubles (64 bytes)
+    static const uint32_t ALIGNMENT = 8;
+
+    GenomeMatrix() = default;
+
+    GenomeMatrix(const uint32_t rows, const uint32_t cols)
+    {
+        resize(rows, cols);
+    }
+
+    // Contents are not preserved
+    void resize(const uint32_t rows, const uint32_t cols);
+
+    uint32_t rows() const
+    {
+        return rowCount;
+    }
+
+    uint32_t cols() const
+    {
+        return colCount;
+    }
+
+    uint32_t stride() const
+    {
+        return rowStride;
+    }
+
+    double * row(const uint32_t i)
+    {
+        return data + size_t(i) * rowStride;
+    }
+
+    const double * row(const uint32_t i) const
+    {
+        return data + size_t(i) * rowStride;
+    }
+
+    // Rows [begin, end)
+    PopulationMatrix view(const uint32_t begin, const uint32_t end) const
+    {
+        PopulationMatrix result;
+        result.data = row(begin);
+        result.rows = end - begin;
+        result.cols = colCount;
+        result.stride = rowStride;
+        return result;
+    }
+
+    PopulationMatrix view() const
+    {
+        return view(0, rowCount);
+    }
+
+    void swap(GenomeMatrix & other);
+
+private:
+    std::unique_ptr<double[]> storage;
+    size_t capacity = 0; // usable doubles starting at data
+    double * data = nullptr;
+
+    uint32_t rowCount = 0;
+    uint32_t colCount = 0;
+    uint32_t rowStride = 0;
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef ISLAND_MODEL_H
+#define ISLAND_MODEL_H
+
+#include <vector>
+#include <memory>
+#include <stdint.h>
+
+#include "common.h"
+#include "Genocop.h"
+#include "GenomeMatrix.h"
+#include "ThreadPool.h"
+
+// Runs several independent Genocop populations ("islands") in parallel.
+// Every migrationInterval generations the best individuals of each island replace the worst
+// individuals of its neighbour. Migration happens between epochs on the calling thread, so for a
+// fixed seed the result does not depend on the number of threads.
+// The objective function is called from several threads at once and must be thread safe.
+class IslandModel
+{
+public:
+    enum class Topology
+    {
+        Ring,   // island i sends to island i + 1
+        Random  // a new random pairing every migration
+    };
+
+    struct Options
+    {
+        uint32_t islandCount = 4;
+        uint32_t migrationInterval = 10; // generations between migrations
+        uint32_t migrantCount = 2;       // individuals sent by each island per migration
+        Topology topology = Topology::Ring;
+
+        // threads running islands (0 -> one per island, up to the number of hardware threads)
+        uint32_t threadCount = 0;
+
+        // Options for every island. island.maxIters is the total number of generations,
+        // island.seed is the seed of the whole model (0 -> from the system clock),
+        // island.threadCount is ignored - each island runs on a single thread.
+        // island.stop applies to the whole model: the global best value, the evaluations of all islands
+        // (each island's memetic stage gets an equal share) and the diversity of the most diverse island.
+        // Checked after every epoch; cancel and maxSeconds also between generations
+        Genocop::Options island;
+    };
+
+    // Called after every migration with the number of generations so far and the global best value
+    typedef std::function<void(uint32_t iteration, double bestValue)> EpochCallback;
+
+    EpochCallback callback = 0;
+
+    IslandModel(const uint32_t vectorSize, ObjectiveFunction objective,
+                const Vector xMin, const Vector xMax);
+
+    IslandModel(const uint32_t vectorSize, BatchObjectiveFunction objective,
+                const Vector xMin, const Vector xMax);
+
+    // Returns the best value found by any island
+    double run(Vector & outSolution, const IslandModel::Options & options);
+
+    // Why the last run stopped
+    Genocop::StopReason stopReason() const
+    {
+        return stopCause;
+    }
+
+private:
+    const uint32_t vectorSize;
+    BatchObjectiveFunction objective;
+    const Vector xMin;
+    const Vector xMax;
+
+    Genocop::StopReason stopCause = Genocop::StopReason::None;
+
+    std::vector<std::unique_ptr<Genocop>> islands;
+    std::unique_ptr<ThreadPool> threadPool;
+
+    // migrants of each island
+    std::vector<GenomeMatrix> migrants;
+    std::vector<std::vector<double>> migrantValues;
+
+    // island i sends its migrants to island targets[i]
+    std::vector<uint32_t> targets;
+
+    void migrate(const IslandModel::Options & options, const uint64_t seed, const uint32_t epoch);
+};
+
+#endif
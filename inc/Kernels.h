@@ -0,0 +1,34 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <stdint.h>
+
+// Element-wise loops used by the genetic operators, over whole genomes of n elements.
+// The implementation (scalar, AVX2 or AVX-512) is chosen once at runtime from the CPU features.
+// All implementations round identically (no fused multiply-add), so results do not depend on the CPU.
+struct Kernels
+{
+    // out[i] = (1 - alpha) * a[i] + alpha * b[i]
+    void (*blend)(const double * a, const double * b, const double alpha, double * out, const uint32_t n);
+
+    // x[i] = min(max(x[i] + mult * dir[i], lo[i]), hi[i])
+    void (*stepClamp)(double * x, const double * dir, const double mult,
+                      const double * lo, const double * hi, const uint32_t n);
+
+    // out[i] = offset[i] + scale[i] * u[i]; out may alias u
+    void (*affine)(const double * offset, const double * scale, const double * u, double * out, const uint32_t n);
+
+    // x[i] *= mult
+    void (*scale)(double * x, const double mult, const uint32_t n);
+
+    // sum of x[i]^2
+    double (*sumSquares)(const double * x, const uint32_t n);
+
+    // name of the selected instruction set
+    const char * name;
+
+    // Implementation for the current CPU
+    static const Kernels & get();
+};
+
+#endif
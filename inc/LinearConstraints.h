@@ -0,0 +1,100 @@
+#ifndef LINEAR_CONSTRAINTS_H
+#define LINEAR_CONSTRAINTS_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "common.h"
+
+// Linear equality and inequality constraints on top of the box bounds, handled the GENOCOP way:
+// - equalities are eliminated: some variables ("pivots") are computed from the others by complete(),
+//   so every individual satisfies them exactly
+// - the feasible region is convex, so a child stays feasible if it's moved back towards a feasible
+//   parent along the segment between them (maxStep)
+// See Genocop::setConstraints.
+class LinearConstraints
+{
+public:
+    explicit LinearConstraints(const uint32_t vectorSize = 0);
+
+    uint32_t vectorSize() const
+    {
+        return n;
+    }
+
+    bool empty() const
+    {
+        return equalityB.empty() && inequalityB.empty();
+    }
+
+    // a . x = b
+    void addEquality(const Vector & a, const double b);
+
+    // a . x <= b (multiply by -1 for >=)
+    void addInequality(const Vector & a, const double b);
+
+    // Eliminate the equalities and find a point inside the feasible region.
+    // Throws if the equalities are inconsistent or no feasible point in the box was found
+    void prepare(const Vector & xMin, const Vector & xMax);
+
+    // =============================================
+    // =============== After prepare() =============
+    // =============================================
+
+    // Variables that are not computed from the others
+    const std::vector<uint32_t> & freeVariables() const
+    {
+        return freeIdx;
+    }
+
+    // Set the pivot variables from the free ones (makes x satisfy the equalities)
+    void complete(double * x) const;
+
+    // x satisfies the inequalities and the box bounds of the pivots, up to rounding, and the free variables
+    // are inside their box. x must be complete
+    bool feasible(const double * x) const;
+
+    // Largest t in [0, 1] such that from + t (to - from) is feasible. from must be feasible, both complete
+    double maxStep(const double * from, const double * to) const;
+
+    // Move all variables into the box. For a feasible x this only undoes the rounding of complete() and of
+    // a step of maxStep, so the equalities still hold up to rounding
+    void clampToBox(double * x) const;
+
+    // Feasible point away from the boundary (the mean of several feasible points)
+    const double * interiorPoint() const
+    {
+        return &interior[0];
+    }
+
+private:
+    uint32_t n;
+
+    // as added: rows of n coefficients
+    std::vector<double> equalityA;
+    std::vector<double> equalityB;
+    std::vector<double> inequalityA;
+    std::vector<double> inequalityB;
+
+    // x[pivots[i]] = pivotConstants[i] - sum_k pivotCoefficients[i][k] x[freeIdx[k]]
+    std::vector<uint32_t> pivots;
+    std::vector<uint32_t> freeIdx;
+    std::vector<double> pivotCoefficients;
+    std::vector<double> pivotConstants;
+
+    // checked rows (a . x <= b): the inequalities and the bounds of the pivots, with their rounding tolerances
+    std::vector<double> rowA;
+    std::vector<double> rowB;
+    std::vector<double> rowTolerance;
+
+    Vector interior;
+    Vector boxMin;
+    Vector boxMax;
+
+    void eliminateEqualities(const Vector & xMin, const Vector & xMax);
+
+    // Cyclic projections onto the constraints, starting from x. Returns true if x ends feasible
+    bool findFeasible(double * x, const Vector & xMin, const Vector & xMax) const;
+};
+
+#endif
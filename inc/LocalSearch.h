@@ -0,0 +1,39 @@
+#ifndef LOCAL_SEARCH_H
+#define LOCAL_SEARCH_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "common.h"
+#include "GenomeMatrix.h"
+
+// Derivative-free local minimization inside box bounds: Nelder-Mead with the dimension-dependent
+// coefficients of Gao and Han (2012), which keep it working in more than a few dimensions.
+// Used by Genocop to refine the best individuals (options.localSearch).
+// Buffers are kept between calls, so repeated calls of the same size don't allocate.
+class NelderMead
+{
+public:
+    // Minimize starting from x, whose value is already known. The initial simplex has one vertex at x
+    // and one per coordinate at distance step[i] (towards the inside of the box).
+    // Stops after maxEvaluations evaluations or when the simplex has collapsed.
+    // x and value are replaced by the best point found. Returns the number of evaluations
+    uint32_t minimize(const BatchObjectiveFunction & objective, double * x, double & value,
+                      const double * xMin, const double * xMax, const double * step,
+                      const uint32_t n, const uint32_t maxEvaluations);
+
+private:
+    GenomeMatrix simplex;    // n + 1 vertices
+    std::vector<double> values;
+    GenomeMatrix trial;      // reflected point, expanded or contracted point
+    std::vector<double> centroid;
+
+    // All vertices are equal to the best one to the precision of the coordinates
+    bool collapsed(const uint32_t best, const uint32_t n) const;
+
+    // Evaluate a row of trial (clamped to the box first)
+    double evaluateTrial(const BatchObjectiveFunction & objective, const uint32_t row,
+                         const double * xMin, const double * xMax);
+};
+
+#endif
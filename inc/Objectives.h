@@ -0,0 +1,50 @@
+#ifndef OBJECTIVES_H
+#define OBJECTIVES_H
+
+#include "common.h"
+
+// Test functions for minimization
+
+// 1-D: x + x sin(20 x), usually searched in [-2, 8]
+double objFunc1(const Vector & x);
+
+// =============================================
+// ================ 2-D and N-D ================
+// =============================================
+// Classic 2-D functions extended to any dimension (same values in 2-D)
+
+// Rosenbrock's banana function summed over consecutive pairs (x[i], x[i + 1]), minimum 0 at (1, ..., 1)
+double banana(const Vector & vec);
+
+// Summed over the pairs (x[0], x[1]), (x[2], x[3]), ... (an odd last element is not used).
+// Four minima of value 0 per pair, e.g. (3, 2)
+double himmelblau(const Vector & vec);
+
+// Levi function N.13 chained over consecutive pairs, minimum 0 at (1, ..., 1)
+double levi13(const Vector & vec);
+
+// =============================================
+// ==================== 2-D ====================
+// =============================================
+
+// (x^2 + 10 y^2)^2, minimum 0 at (0, 0)
+double f2d(const Vector & vec);
+
+// =============================================
+// ==================== N-D ====================
+// =============================================
+// Minimum 0 at the origin
+
+// Many regular local minima, searched in [-5.12, 5.12]
+double rastrigin(const Vector & vec);
+
+// Sum of squares
+double sphere(const Vector & vec);
+
+// Nearly flat outer region with a deep hole in the middle, searched in [-32.768, 32.768]
+double ackley(const Vector & vec);
+
+// Many local minima on a wide parabola, searched in [-600, 600]
+double griewank(const Vector & vec);
+
+#endif
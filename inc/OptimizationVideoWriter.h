@@ -2,14 +2,83 @@
 #define OPTIMIZATION_VIDEO_WRITER_H
 
 #include <string>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <opencv2/opencv.hpp>
 #include "common.h"
 #include "Genocop.h"
+#include "PopulationProjection.h"
+#include "ThreadPool.h"
 
+// Draws the population of every generation over the objective function and writes the frames to a video.
+// Frames are drawn and encoded on background threads: drawFrame only copies the coordinates to a queue
 class OptimizationVideoWriter
 {
 public:
 
+    // What drawFrame does when the queue is full
+    enum class Backpressure
+    {
+        Block,  // wait for a free slot: every frame is written
+        Drop    // skip the frame: the optimizer never waits
+    };
+
+    // Frame pipeline: drawFrame -> queue -> raster threads -> encoder thread (in order) -> video file
+    struct PipelineOptions
+    {
+        uint32_t queueFrames = 8;    // frames queued or in progress
+        uint32_t rasterThreads = 1;  // threads drawing the frames
+        Backpressure backpressure = Backpressure::Block;
+    };
+
+    // How the individuals are drawn
+    enum class FrameStyle
+    {
+        Points,  // a dot per individual
+        Density  // a heatmap of the number of individuals per cell: the cost doesn't depend on the population size
+    };
+
+    struct FrameOptions
+    {
+        FrameStyle style = FrameStyle::Points;
+
+        // Density: cells of cellSize x cellSize pixels. log(1 + count) relative to the fullest cell is colored
+        // with the OpenCV colormap and blended over the background with this opacity; empty cells show the background
+        uint32_t cellSize = 4;
+        int colormap = cv::COLORMAP_INFERNO;
+        double opacity = 0.8;
+
+        // A line through the successive best solutions since the first generation
+        bool trajectory = false;
+    };
+
+    // How drawBackground evaluates the objective over the image
+    struct BackgroundOptions
+    {
+        // Threads evaluating tiles of rows (0 -> all hardware threads). With more than one thread
+        // the objective must be safe to call concurrently, so the default is serial
+        uint32_t threadCount = 1;
+        uint32_t tileRows = 8;     // image rows per task
+
+        // Progressive rendering: the first pass samples every 2^coarseLevels-th pixel of every 2^coarseLevels-th row,
+        // each following pass halves the spacing. Every pixel is still evaluated once
+        uint32_t coarseLevels = 0;
+
+        // Called after every pass except the last with the background so far (each sample fills its block)
+        // and the level of the pass (coarseLevels, ..., 1)
+        std::function<void(const cv::Mat & background, uint32_t level)> preview;
+    };
+
+    // Optional (not owned): maps the genomes to the image plane and is updated with every frame, on the thread
+    // calling drawFrame. Without it x[0] and x[1] are drawn. The image range is then in projected units (about
+    // -2 to 2 shows a spread population) and drawBackground makes no sense
+    PopulationProjection * projection = nullptr;
+
     OptimizationVideoWriter(const uint32_t w, const uint32_t h,
                             const double xs, const double xe,
                             const double ys, const double ye) :
@@ -20,12 +89,51 @@ public:
         drawGrid();
     }
 
+    // Background of the frames: the objective on the image grid, scaled to [0, 1], raised to gamma
+    // (< 1 shows more detail near the minimum) and shown as gray levels.
+    // The objective is called with whole rows of pixels (in parallel, see BackgroundOptions)
+    void drawBackground(BatchObjectiveFunction objFun, const double gamma, const BackgroundOptions & options);
+
+    // Same with the default options (serial, one pixel per call)
     void drawBackground(ObjectiveFunction objFun, const double gamma = 1.0);
 
-    void drawFrame(const std::vector<Genocop::Score> & population);
+    // Finishes the video
+    ~OptimizationVideoWriter();
+
+    OptimizationVideoWriter(const OptimizationVideoWriter &) = delete;
+    OptimizationVideoWriter & operator=(const OptimizationVideoWriter &) = delete;
+
+    // Queue a frame with the first two coordinates (or the projection) of each individual.
+    // Returns false if it was dropped (Backpressure::Drop). Before begin() the frame is written directly.
+    // Throws if the genomes don't have the dimension of the projection (or fewer than 2 genes without one)
+    bool drawFrame(const std::vector<Genocop::Score> & population);
+
+    // Same from a Genocop observer (Genocop::subscribe), without copying the population first
+    bool drawFrame(const Genocop::PopulationView & population);
 
     void begin(const std::string & filename);
 
+    void begin(const std::string & filename, const PipelineOptions & options);
+
+    // Style of the following frames (the queued ones are drawn with the old style)
+    void setFrameOptions(const FrameOptions & options);
+
+    // Block until every queued frame is written
+    void flush();
+
+    // Write the queued frames, stop the threads and close the file
+    void end();
+
+    uint64_t framesWritten() const
+    {
+        return writtenCount.load(std::memory_order_relaxed);
+    }
+
+    uint64_t framesDropped() const
+    {
+        return droppedCount.load(std::memory_order_relaxed);
+    }
+
 private:
     const uint32_t WIDTH;
     const uint32_t HEIGHT;
@@ -39,7 +147,127 @@ private:
     cv::Mat backgroundImg;
     cv::VideoWriter videoWriter;
 
+    // objective values of the pixels (CV_64FC1), filled by drawBackground
+    cv::Mat backgroundValues;
+
+    // background workers, kept between calls; null if the current call is serial
+    std::unique_ptr<ThreadPool> threadPool;
+    ThreadPool * activePool = nullptr;
+
+    // per thread: the points of a row (x, y pairs) and their values
+    std::vector<std::vector<double>> rowPoints;
+    std::vector<std::vector<double>> rowValues;
+    // per thread: range of the sampled values
+    std::vector<double> threadMin;
+    std::vector<double> threadMax;
+
+    // Run body(begin, end, threadIdx) over [0, count) on the active pool or on the calling thread
+    template <class Body>
+    void parallelFor(const uint32_t count, const Body & body, const uint32_t grainSize = 0)
+    {
+        if (activePool != nullptr)
+        {
+            activePool->parallelFor(count, body, grainSize);
+        }
+        else
+        {
+            body(0, count, 0);
+        }
+    }
+
+    // Evaluate the pixels of one pass: rows and columns that are multiples of stride,
+    // except the ones of the previous pass (multiples of 2 stride) unless first
+    void evaluateBackground(const BatchObjectiveFunction & objFun, const uint32_t stride, const bool first,
+                            const uint32_t tileRows);
+
+    // backgroundImg from the pixels sampled every stride pixels (each one fills its stride x stride block)
+    void renderBackground(const uint32_t stride, const double gamma);
+
     void drawGrid();    
+
+    // =============================================
+    // =============== Frame pipeline ==============
+    // =============================================
+
+    // Frame number k uses slot k % slots.size(); frames are encoded in order, so slots are freed in order
+    struct FrameSlot
+    {
+        enum State
+        {
+            Free,
+            Queued,     // points copied, waiting for a raster thread
+            Drawing,
+            Drawn       // waiting for the encoder
+        } state = Free;
+
+        std::vector<cv::Point2f> points; // image coordinates
+        std::vector<cv::Point> trajectory;
+        cv::Mat image;                   // kept between frames
+
+        // density style
+        std::vector<uint32_t> histogram;
+        cv::Mat levels;                  // CV_8UC1, one pixel per cell
+        cv::Mat colors;
+    };
+    std::vector<FrameSlot> slots;
+    FrameOptions frameOptions;
+
+    // best-so-far trajectory, captured with every frame. The solutions are kept because the axes of
+    // a projection move between frames: the whole line is projected again with the current ones
+    std::vector<cv::Point> trajectory;
+    std::vector<double> trajectoryGenomes; // rows of the vector size
+    double trajectoryBest = 1e+99;
+    PipelineOptions pipeline;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    uint64_t nextFrame = 0;   // next frame number given by drawFrame
+    uint64_t nextDraw = 0;    // next frame taken by a raster thread
+    uint64_t nextEncode = 0;  // next frame to encode
+    bool running = false;
+    bool stopping = false;
+
+    std::atomic<uint64_t> writtenCount{0};
+    std::atomic<uint64_t> droppedCount{0};
+
+    std::vector<std::thread> rasterThreads;
+    std::thread encoderThread;
+
+    // synchronous drawFrame before begin()
+    FrameSlot directFrame;
+
+    void rasterLoop();
+    void encoderLoop();
+
+    // Queue a frame: capture(slot) copies the coordinates to the slot
+    template <class Capture>
+    bool queueFrame(const Capture & capture);
+
+    // Copy the coordinates of the population to the slot
+    void capture(const std::vector<Genocop::Score> & population, FrameSlot & slot);
+    void capture(const Genocop::PopulationView & population, FrameSlot & slot);
+
+    // scratch: rows of a std::vector<Score> population for the projection
+    std::vector<double> packedRows;
+
+    // Throws if toImage() can't read genomes of cols genes
+    void checkGenomeSize(const uint32_t cols) const;
+
+    // Image coordinates of a genome (projected if there is a projection)
+    cv::Point2f toImage(const double * x) const;
+
+    // Add the best solution to the trajectory if it improved, and bring the image coordinates of the
+    // trajectory up to date with the projection
+    void extendTrajectory(const double value, const double * x, const uint32_t cols);
+
+    // Append the image point of a genome unless it is the same as the last one
+    void addTrajectoryPoint(const double * x);
+
+    // Draw the frame of the slot over the background
+    void rasterize(FrameSlot & slot) const;
+
+    // Density style: count the individuals per cell and blend the colored counts over the image
+    void drawDensity(FrameSlot & slot) const;
 };
 
 #endif
\ No newline at end of file
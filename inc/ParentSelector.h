@@ -0,0 +1,86 @@
+#ifndef PARENT_SELECTOR_H
+#define PARENT_SELECTOR_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "Random.h"
+
+// Selects parents from a scored population (lower score = better).
+// prepare() ranks the population once per generation; after that the selection
+// functions only read the selector's state, so they can be called from several threads
+// at once as long as each thread has its own random engine.
+class ParentSelector
+{
+public:
+    typedef Random Engine;
+
+    enum class Method
+    {
+        // best of tournament.size random individuals wins with probability tournament.p,
+        // otherwise the second best wins with probability p, etc.
+        Tournament,
+        // probability decreases linearly with rank
+        LinearRanking,
+        // linear ranking probabilities, sampled with a single spin of equally spaced pointers
+        // (lowest variance of the number of copies of each individual)
+        StochasticUniversal,
+        // uniform among the best truncation.fraction of the population
+        Truncation
+    };
+
+    struct Settings
+    {
+        Method method = Method::Tournament;
+
+        uint32_t tournamentSize = 4;
+        double tournamentP = 0.9;
+
+        // expected number of copies of the best individual, in [1, 2]. 1 = uniform
+        double rankingPressure = 1.5;
+
+        // fraction of the population that can be selected, in (0, 1]
+        double truncationFraction = 0.3;
+    };
+
+    // Rank scores and precompute the selection distributions
+    void prepare(const std::vector<double> & scores, const Settings & settings);
+
+    // Move individual idx to its place in the ranking after its score changed. O(N)
+    void rerank(const std::vector<double> & scores, const uint32_t idx);
+
+    // Population indices sorted from best to worst (ties broken by index)
+    const std::vector<uint32_t> & ranking() const
+    {
+        return ranks;
+    }
+
+    // Select outParents.size() population indices (with possible repetition)
+    void select(std::vector<uint32_t> & outParents, Engine & rng) const;
+
+    // Select a single parent. Not available for StochasticUniversal, which selects all parents at once
+    uint32_t selectOne(Engine & rng) const;
+
+private:
+    Settings settings;
+    uint32_t populationCount = 0;
+
+    // population indices, best first
+    std::vector<uint32_t> ranks;
+
+    // tournamentCdf[i] = probability that one of the i + 1 best participants wins
+    std::vector<double> tournamentCdf;
+
+    // rankingCdf[i] = probability of selecting one of the i + 1 best individuals (linear ranking)
+    std::vector<double> rankingCdf;
+    double rankingPressure = 0; // pressure rankingCdf was computed for
+
+    // individuals with rank < truncationCount can be selected
+    uint32_t truncationCount = 0;
+
+    uint32_t runTournament(Engine & rng) const;
+    uint32_t sampleRanking(Engine & rng) const;
+    void stochasticUniversal(std::vector<uint32_t> & outParents, Engine & rng) const;
+};
+
+#endif
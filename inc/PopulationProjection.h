@@ -0,0 +1,86 @@
+#ifndef POPULATION_PROJECTION_H
+#define POPULATION_PROJECTION_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "common.h"
+
+// Maps genomes of any dimension to a plane, e.g. to draw high-dimensional populations (OptimizationVideoWriter).
+// Genes are first scaled to [-1, 1] by the box, so the box center projects to (0, 0), the whole box to within
+// +-sqrt(dimension) and a uniformly spread population to about +-0.6.
+// Pca follows the two main directions of the population: every update() adds the generation to a decaying
+// covariance estimate through a step of subspace (power) iteration that starts from the current axes,
+// so it costs O(populationCount * dimension) and never forms the dimension x dimension matrix.
+class PopulationProjection
+{
+public:
+    enum class Method
+    {
+        Random, // two fixed random orthonormal axes
+        Pca     // principal components, updated incrementally
+    };
+
+    struct Options
+    {
+        Method method = Method::Pca;
+        uint32_t powerIterations = 1; // per update; more follow sudden changes faster
+        double memory = 0.8;          // weight of the previous generations in the estimate, 0 -> only the last one
+        uint64_t seed = 1;            // random axes, and the initial Pca axes
+    };
+
+    PopulationProjection(const Vector & xMin, const Vector & xMax);
+    PopulationProjection(const Vector & xMin, const Vector & xMax, const Options & options);
+
+    uint32_t dimension() const
+    {
+        return n;
+    }
+
+    // Add a generation (rows of dimension genes). Does nothing for Random. Throws if the rows have another size
+    void update(const PopulationMatrix & population);
+
+    // Coordinates of x (dimension genes) on the two axes
+    void project(const double * x, double & outX, double & outY) const
+    {
+        double sx = 0;
+        double sy = 0;
+        for (uint32_t k = 0; k < n; k++)
+        {
+            const double z = (x[k] - center[k]) * invScale[k];
+            sx += z * axes[k];
+            sy += z * axes[n + k];
+        }
+        outX = sx;
+        outY = sy;
+    }
+
+    // Unit axis 0 or 1, in scaled genes
+    const double * axis(const uint32_t i) const
+    {
+        return &axes[size_t(i) * n];
+    }
+
+private:
+    uint32_t n;
+    Options options;
+
+    // scaling of the genes to [-1, 1]
+    std::vector<double> center;
+    std::vector<double> invScale;
+
+    std::vector<double> axes;      // 2 rows of n
+    // Pca state: decaying mean, covariance times the axes, and the same before the current generation
+    std::vector<double> mean;
+    std::vector<double> sketch;
+    std::vector<double> previousSketch;
+    std::vector<double> batchMean;
+    std::vector<double> centered;
+    std::vector<double> basis;     // scratch for orthonormalize
+    uint64_t updates = 0;
+
+    // Orthonormalize the sketch into the axes, keeping their directions. False if the population has no spread
+    bool orthonormalize();
+};
+
+#endif
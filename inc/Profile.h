@@ -0,0 +1,79 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <chrono>
+#include <stdint.h>
+
+// Hot-path instrumentation of Genocop. Only compiled in with -DGENOCOP_PROFILE
+// (CMake option GENOCOP_PROFILE); otherwise GENOCOP_PROFILE_SCOPE expands to nothing.
+
+enum class ProfilePhase : uint8_t
+{
+    CalculateScores,    // objective evaluation (and cache lookups)
+    SelectParents,
+    ClassicCrossover,
+    LinearCrossover,
+    HeuristicCrossover,
+    FineMutation,
+    FullMutation,
+    LocalSearch,        // memetic refinement and final polish (objective evaluations included)
+    Count
+};
+
+static const uint32_t PROFILE_PHASE_COUNT = uint32_t(ProfilePhase::Count);
+
+inline const char * profilePhaseName(const ProfilePhase phase)
+{
+    static const char * names[PROFILE_PHASE_COUNT] =
+    {
+        "calculateScores", "selectParents", "classicCrossover", "linearCrossover",
+        "heuristicCrossover", "fineRangeMutation", "fullRangeMutation", "localSearch"
+    };
+    return names[uint32_t(phase)];
+}
+
+struct PhaseStats
+{
+    uint64_t calls = 0;
+    uint64_t nanoseconds = 0; // summed over threads
+};
+
+// Counters of one thread, on their own cache lines
+struct ProfileCounters
+{
+    PhaseStats phases[PROFILE_PHASE_COUNT];
+    char padding[64];
+};
+
+// Adds the lifetime of the scope to one phase
+class ProfileScope
+{
+public:
+    ProfileScope(ProfileCounters & counters, const ProfilePhase phase) :
+        stats(counters.phases[uint32_t(phase)]), start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ProfileScope()
+    {
+        stats.calls++;
+        stats.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope & operator=(const ProfileScope &) = delete;
+
+private:
+    PhaseStats & stats;
+    const std::chrono::steady_clock::time_point start;
+};
+
+#ifdef GENOCOP_PROFILE
+#define GENOCOP_PROFILE_CONCAT2(a, b) a##b
+#define GENOCOP_PROFILE_CONCAT(a, b) GENOCOP_PROFILE_CONCAT2(a, b)
+#define GENOCOP_PROFILE_SCOPE(counters, phase) ProfileScope GENOCOP_PROFILE_CONCAT(profileScope, __LINE__)(counters, phase)
+#else
+#define GENOCOP_PROFILE_SCOPE(counters, phase)
+#endif
+
+#endif
@@ -0,0 +1,195 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cmath>
+#include <limits>
+#include <stdint.h>
+
+// xoshiro256** generator (Blackman & Vigna, "Scrambled linear pseudorandom number generators", 2018)
+// seeded through SplitMix64.
+//
+// Independent streams are derived from a seed and a pair of counters (e.g. generation and individual),
+// so any stream can be created directly without advancing the others - work can be split between
+// threads in any way and still produce the same numbers.
+// Satisfies UniformRandomBitGenerator, so it also works with the <random> distributions.
+class Random
+{
+public:
+    typedef uint64_t result_type;
+
+    static constexpr uint64_t min()
+    {
+        return 0;
+    }
+
+    static constexpr uint64_t max()
+    {
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+    explicit Random(const uint64_t seed = 0)
+    {
+        this->seed(seed);
+    }
+
+    void seed(uint64_t seed)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            s[i] = splitMix64(seed);
+        }
+        hasSpareNormal = false;
+    }
+
+    // Stream number (a, b) of the given seed
+    static Random stream(const uint64_t seed, const uint64_t a, const uint64_t b)
+    {
+        uint64_t h = seed;
+        uint64_t key = splitMix64(h);
+        h = key ^ a;
+        key = splitMix64(h);
+        h = key ^ b;
+        return Random(splitMix64(h));
+    }
+
+    inline uint64_t operator()()
+    {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+
+        return result;
+    }
+
+    // Advance by 2^128 steps: gives 2^128 non-overlapping subsequences
+    void jump()
+    {
+        static const uint64_t JUMP[] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+
+        uint64_t t[4] = {0, 0, 0, 0};
+        for (int i = 0; i < 4; i++)
+        {
+            for (int b = 0; b < 64; b++)
+            {
+                if (JUMP[i] & (uint64_t(1) << b))
+                {
+                    for (int j = 0; j < 4; j++)
+                        t[j] ^= s[j];
+                }
+                (*this)();
+            }
+        }
+
+        for (int j = 0; j < 4; j++)
+            s[j] = t[j];
+        hasSpareNormal = false;
+    }
+
+    // [0, 1)
+    inline double uniform()
+    {
+        return ((*this)() >> 11) * (1.0 / 9007199254740992.0); // 53 bits / 2^53
+    }
+
+    // [lo, hi)
+    inline double uniform(const double lo, const double hi)
+    {
+        return lo + (hi - lo) * uniform();
+    }
+
+    // [0, n), n > 0. Multiply-shift mapping (Lemire); the bias is negligible for 32-bit n
+    inline uint32_t index(const uint32_t n)
+    {
+        return uint32_t(((*this)() >> 32) * n >> 32);
+    }
+
+    // Standard normal value (Marsaglia polar method)
+    inline double normal()
+    {
+        if (hasSpareNormal)
+        {
+            hasSpareNormal = false;
+            return spareNormal;
+        }
+
+        double u, v, r;
+        do
+        {
+            u = uniform(-1.0, 1.0);
+            v = uniform(-1.0, 1.0);
+            r = u * u + v * v;
+        } while (r >= 1.0 || r == 0.0);
+
+        const double mult = std::sqrt(-2.0 * std::log(r) / r);
+        spareNormal = v * mult;
+        hasSpareNormal = true;
+        return u * mult;
+    }
+
+    void fillUniform(double * out, const uint32_t count, const double lo, const double hi)
+    {
+        const double range = hi - lo;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            out[i] = lo + range * uniform();
+        }
+    }
+
+    void fillNormal(double * out, const uint32_t count)
+    {
+        uint32_t i = 0;
+        if (hasSpareNormal && count > 0)
+        {
+            out[i++] = normal();
+        }
+
+        // two values per iteration without going through the spare
+        for (; i + 2 <= count; i += 2)
+        {
+            double u, v, r;
+            do
+            {
+                u = uniform(-1.0, 1.0);
+                v = uniform(-1.0, 1.0);
+                r = u * u + v * v;
+            } while (r >= 1.0 || r == 0.0);
+
+            const double mult = std::sqrt(-2.0 * std::log(r) / r);
+            out[i] = u * mult;
+            out[i + 1] = v * mult;
+        }
+
+        if (i < count)
+        {
+            out[i] = normal();
+        }
+    }
+
+private:
+    uint64_t s[4];
+
+    double spareNormal = 0;
+    bool hasSpareNormal = false;
+
+    static inline uint64_t rotl(const uint64_t x, const int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    // Advances x and returns the next SplitMix64 output
+    static inline uint64_t splitMix64(uint64_t & x)
+    {
+        uint64_t z = (x += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef SOBOL_H
+#define SOBOL_H
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+// Sobol low-discrepancy sequence with 32-bit coordinates, used for quasi-random initial populations.
+// Dimensions 2 to 40 use the direction numbers of Joe and Kuo (2008). Higher dimensions use the next
+// primitive polynomials with fixed pseudo-random initial direction numbers, which are less uniform
+// but still stratify every single dimension perfectly.
+class SobolSequence
+{
+public:
+    explicit SobolSequence(const uint32_t dimension);
+
+    uint32_t dimension() const
+    {
+        return dimensionCount;
+    }
+
+    // Coordinate d of point index as a fraction of 2^32.
+    // Any 2^k consecutive points starting at a multiple of 2^k put one point in every 2^-k interval of each dimension
+    uint32_t coordinate(const uint32_t index, const uint32_t d) const
+    {
+        const uint32_t * v = &directions[size_t(d) * BITS];
+        uint32_t x = 0;
+        uint32_t b = 0;
+        for (uint32_t i = index; i != 0; i >>= 1, b++)
+        {
+            if (i & 1)
+                x ^= v[b];
+        }
+        return x;
+    }
+
+private:
+    static const uint32_t BITS = 32;
+
+    uint32_t dimensionCount;
+    std::vector<uint32_t> directions; // BITS direction numbers per dimension
+};
+
+#endif
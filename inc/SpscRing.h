@@ -0,0 +1,75 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <vector>
+#include <atomic>
+#include <stdint.h>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+// push() and pop() never block and never allocate; the slots are allocated by the constructor.
+template <class T>
+class SpscRing
+{
+public:
+    // capacity is rounded up to a power of 2
+    explicit SpscRing(const uint32_t capacity)
+    {
+        uint32_t size = 1;
+        while (size < capacity)
+        {
+            size *= 2;
+        }
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing & operator=(const SpscRing &) = delete;
+
+    uint32_t capacity() const
+    {
+        return mask + 1;
+    }
+
+    // Producer side. Returns false if the ring is full
+    bool push(const T & item)
+    {
+        const uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) > mask)
+            return false;
+
+        slots[h & mask] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the ring is empty
+    bool pop(T & outItem)
+    {
+        const uint64_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+            return false;
+
+        outItem = slots[t & mask];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> slots;
+    uint64_t mask = 0;
+
+    // the indices only grow; each one is written by one side and kept on its own cache line
+    char padding0[64];
+    std::atomic<uint64_t> head{0}; // next slot to write
+    char padding1[64];
+    std::atomic<uint64_t> tail{0}; // next slot to read
+    char padding2[64];
+};
+
+#endif
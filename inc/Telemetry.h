@@ -0,0 +1,89 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <string>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <stdint.h>
+
+#include "SpscRing.h"
+
+// Statistics of one generation
+struct GenerationRecord
+{
+    uint32_t iteration = 0;
+    uint64_t evaluations = 0;   // since start()
+    double elapsedSeconds = 0;  // since start()
+
+    // objective values of the population
+    double best = 0;            // best found so far
+    double mean = 0;
+    double stddev = 0;
+    double diversity = 0;       // see Genocop::populationDiversity()
+
+    // how the children were created
+    uint32_t eliteChildren = 0;
+    uint32_t copiedChildren = 0;
+    uint32_t classicCrossovers = 0;
+    uint32_t linearCrossovers = 0;
+    uint32_t heuristicCrossovers = 0;
+    uint32_t fineMutations = 0;
+    uint32_t fullMutations = 0;
+
+    // Time per phase. Selection is wall-clock time, the others are summed over the threads
+    double selectionSeconds = 0;
+    double crossoverSeconds = 0;
+    double mutationSeconds = 0;
+    double evaluationSeconds = 0;
+};
+
+// Writes generation records to a CSV or JSON lines file on a background thread.
+// The optimizer only copies the record into a lock-free ring, so it never waits for the disk.
+// One producer: a writer can be shared by several optimizers only if they run one after another.
+class TelemetryWriter
+{
+public:
+    enum class Format
+    {
+        Csv,        // header line + one line per record
+        JsonLines   // one JSON object per line
+    };
+
+    // Throws if the file can't be opened
+    TelemetryWriter(const std::string & filename, const Format format, const uint32_t capacity = 4096);
+
+    // Writes the remaining records and closes the file
+    ~TelemetryWriter();
+
+    TelemetryWriter(const TelemetryWriter &) = delete;
+    TelemetryWriter & operator=(const TelemetryWriter &) = delete;
+
+    // Queue a record. If the ring is full the record is dropped and false is returned
+    bool push(const GenerationRecord & record);
+
+    // Block until every queued record is written
+    void flush();
+
+    // Records lost because the ring was full
+    uint64_t dropped() const
+    {
+        return droppedCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    const Format format;
+    std::ofstream file;
+    SpscRing<GenerationRecord> ring;
+
+    std::atomic<uint64_t> pushedCount{0};
+    std::atomic<uint64_t> writtenCount{0};
+    std::atomic<uint64_t> droppedCount{0};
+    std::atomic<bool> stopping{false};
+    std::thread drainThread;
+
+    void drain();
+    void write(const GenerationRecord & record);
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <stdint.h>
+
+// Persistent pool of worker threads for data-parallel loops.
+// The thread calling parallelFor participates as worker 0, so a pool of size N
+// owns N - 1 background threads. Threads are kept alive between calls.
+class ThreadPool
+{
+public:
+    // Loop body: process indices [begin, end) on worker threadIdx
+    typedef std::function<void(uint32_t begin, uint32_t end, uint32_t threadIdx)> RangeFunction;
+
+    // threadCount = 0 -> use all hardware threads
+    explicit ThreadPool(uint32_t threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool & operator=(const ThreadPool &) = delete;
+
+    uint32_t size() const
+    {
+        return threadCount;
+    }
+
+    // Run body over [0, count) split into chunks of at most grainSize indices (0 -> automatic).
+    // Chunks are handed out dynamically, so uneven work per index is balanced.
+    // Blocks until all chunks are done. The first exception thrown by body is rethrown here.
+    // Body is any callable with the RangeFunction signature; it is not copied, so this doesn't allocate.
+    template <class Body>
+    void parallelFor(uint32_t count, const Body & body, uint32_t grainSize = 0)
+    {
+        run(count, &body, &invoke<Body>, grainSize);
+    }
+
+private:
+    uint32_t threadCount;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+
+    typedef void (*Invoker)(const void * body, uint32_t begin, uint32_t end, uint32_t threadIdx);
+
+    template <class Body>
+    static void invoke(const void * body, uint32_t begin, uint32_t end, uint32_t threadIdx)
+    {
+        (*static_cast<const Body *>(body))(begin, end, threadIdx);
+    }
+
+    // current job - valid while a parallelFor call is active
+    const void * job = nullptr;
+    Invoker jobInvoker = nullptr;
+    uint32_t jobCount = 0;
+    uint32_t jobGrain = 1;
+    uint64_t jobGeneration = 0;
+    uint32_t activeWorkers = 0;
+    std::atomic<uint32_t> nextChunk;
+    std::exception_ptr jobError;
+    bool stopping = false;
+
+    void run(uint32_t count, const void * body, Invoker invoker, uint32_t grainSize);
+
+    void workerLoop(const uint32_t threadIdx);
+
+    // Process chunks until none are left
+    void runChunks(const uint32_t threadIdx);
+};
+
+#endif
@@ -12,6 +12,26 @@ typedef std::valarray<double> Vector;
 // Objective function to be minimized
 typedef std::function<double(const Vector &)> ObjectiveFunction;
 
+// Read-only row-major matrix of individuals: one individual per row, rows are stride elements apart
+struct PopulationMatrix
+{
+    const double * data;
+    uint32_t rows;   // number of individuals
+    uint32_t cols;   // vector size
+    uint32_t stride; // distance between the starts of consecutive rows (>= cols)
+
+    const double * row(const uint32_t i) const
+    {
+        return data + size_t(i) * stride;
+    }
+};
+
+// Objective function that scores a whole population at once: outScores[i] = f(population.row(i))
+typedef std::function<void(const PopulationMatrix & population, double * outScores)> BatchObjectiveFunction;
+
+// Wrap a per-individual objective function into a batch one
+BatchObjectiveFunction makeBatchObjective(ObjectiveFunction objective);
+
 void printVector(const Vector & x, std::ostream & stream, const std::string & separator);
 
 std::ostream & operator<<(std::ostream & stream, const Vector & x);
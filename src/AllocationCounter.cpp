@@ -0,0 +1,26 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> allocationCount(0);
+
+uint64_t getAllocationCount()
+{
+    return allocationCount.load();
+}
+
+void * operator new(size_t size)
+{
+    allocationCount++;
+    void * ptr = std::malloc(size > 0 ? size : 1);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void * ptr) noexcept
+{
+    std::free(ptr);
+}
@@ -0,0 +1,461 @@
+#include "BatchObjectives.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+
+#include "Random.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OBJECTIVES_X86
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+
+typedef void (*BatchFunction)(const PopulationMatrix & population, double * outScores);
+
+static const double PI = 3.14159265358979323846;
+
+// =============================================
+// ================== Helpers ==================
+// =============================================
+// The row functions below are written as loops over blocks of LANES independent elements, which the
+// compiler turns into SIMD code for every instruction set the batch functions are compiled for.
+// Sums go to LANES partial sums added in order at the end (like Kernels::sumSquares), so every
+// instruction set gives the same result.
+
+static const uint32_t LANES = 8;
+
+// sum of term(i) for i in [0, n)
+template <class Term>
+ALWAYS_INLINE double laneSum(const uint32_t n, const Term & term)
+{
+    double lanes[LANES] = {0};
+    uint32_t i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        for (uint32_t j = 0; j < LANES; j++)
+            lanes[j] += term(i + j);
+    }
+    for (; i < n; i++)
+    {
+        lanes[i % LANES] += term(i);
+    }
+
+    double sum = 0;
+    for (uint32_t j = 0; j < LANES; j++)
+        sum += lanes[j];
+    return sum;
+}
+
+// product of term(i) for i in [0, n)
+template <class Term>
+ALWAYS_INLINE double laneProduct(const uint32_t n, const Term & term)
+{
+    double lanes[LANES] = {1, 1, 1, 1, 1, 1, 1, 1};
+    uint32_t i = 0;
+    for (; i + LANES <= n; i += LANES)
+    {
+        for (uint32_t j = 0; j < LANES; j++)
+            lanes[j] *= term(i + j);
+    }
+    for (; i < n; i++)
+    {
+        lanes[i % LANES] *= term(i);
+    }
+
+    double product = 1;
+    for (uint32_t j = 0; j < LANES; j++)
+        product *= lanes[j];
+    return product;
+}
+
+// Round to the nearest integer (|x| < 2^51) without a libm call
+ALWAYS_INLINE double roundNearest(const double x)
+{
+    const double MAGIC = 6755399441055744.0; // 1.5 * 2^52
+    return (x + MAGIC) - MAGIC;
+}
+
+// sin(x) (cosine = false) or cos(x): reduction to [-pi/4, pi/4] in three steps (Cody & Waite)
+// and the minimax polynomials of the Cephes library. About 1e-16 absolute error for |x| < 1e6
+ALWAYS_INLINE double sinOrCos(const double x, const bool cosine)
+{
+    const double PIO2_1 = 1.57079625129699707031;
+    const double PIO2_2 = 7.54978941586159635335e-8;
+    const double PIO2_3 = 5.39030285815811905290e-15;
+
+    const double q = roundNearest(x * (2.0 / PI));
+    const double r = ((x - q * PIO2_1) - q * PIO2_2) - q * PIO2_3;
+    const double z = r * r;
+
+    const double s = r + r * z * (((((1.58962301576546568060e-10 * z - 2.50507477628578072866e-8) * z
+                                    + 2.75573136213857245213e-6) * z - 1.98412698295895385996e-4) * z
+                                    + 8.33333333332211858878e-3) * z - 1.66666666666666307295e-1);
+    const double c = 1.0 - 0.5 * z + z * z * (((((-1.13585365213876817300e-11 * z + 2.08757008419747316778e-9) * z
+                                               - 2.75573141792967388112e-7) * z + 2.48015872888517045348e-5) * z
+                                               - 1.38888888888730564116e-3) * z + 4.16666666666665929218e-2);
+
+    // quadrant (q mod 4, cos(x) = sin(x + pi/2)): s, c, -s, -c.
+    // Selected with exact arithmetic instead of integers and branches, which keep the loops from being vectorized
+    const double shifted = cosine ? q + 1 : q;
+    const double quadrant = shifted - 4 * roundNearest(shifted * 0.25 - 0.375); // 0..3
+    const double negative = roundNearest(quadrant * 0.5 - 0.25);               // 0 0 1 1
+    const double odd = quadrant - 2 * negative;                                  // 0 1 0 1
+    const double value = odd * c + (1 - odd) * s;
+    return (1 - 2 * negative) * value;
+}
+
+// =============================================
+// ================ Row functions ==============
+// =============================================
+
+ALWAYS_INLINE double sphereRow(const double * x, const uint32_t n)
+{
+    return laneSum(n, [x](uint32_t i) { return x[i] * x[i]; });
+}
+
+// 10^(6 i / (n - 1)), cached per thread for the last dimension
+static const double * ellipsoidCoefficients(const uint32_t n)
+{
+    static thread_local std::vector<double> coefficients;
+    if (coefficients.size() != n)
+    {
+        coefficients.resize(n);
+        for (uint32_t i = 0; i < n; i++)
+            coefficients[i] = n > 1 ? std::pow(10.0, 6.0 * i / (n - 1)) : 1.0;
+    }
+    return coefficients.data();
+}
+
+ALWAYS_INLINE double ellipsoidRow(const double * x, const uint32_t n)
+{
+    const double * coefficients = ellipsoidCoefficients(n);
+    return laneSum(n, [x, coefficients](uint32_t i) { return coefficients[i] * x[i] * x[i]; });
+}
+
+ALWAYS_INLINE double bentCigarRow(const double * x, const uint32_t n)
+{
+    return x[0] * x[0] + 1e6 * sphereRow(x + 1, n - 1);
+}
+
+ALWAYS_INLINE double discusRow(const double * x, const uint32_t n)
+{
+    return 1e6 * x[0] * x[0] + sphereRow(x + 1, n - 1);
+}
+
+ALWAYS_INLINE double rosenbrockRow(const double * x, const uint32_t n)
+{
+    return laneSum(n - 1, [x](uint32_t i)
+    {
+        const double a = 1.0 - x[i];
+        const double b = x[i + 1] - x[i] * x[i];
+        return a * a + 100.0 * b * b;
+    });
+}
+
+ALWAYS_INLINE double rastriginRow(const double * x, const uint32_t n)
+{
+    return 10.0 * n + laneSum(n, [x](uint32_t i) { return x[i] * x[i] - 10.0 * sinOrCos(2 * PI * x[i], true); });
+}
+
+ALWAYS_INLINE double ackleyRow(const double * x, const uint32_t n)
+{
+    const double sumSq = sphereRow(x, n);
+    const double sumCos = laneSum(n, [x](uint32_t i) { return sinOrCos(2 * PI * x[i], true); });
+    return -20.0 * std::exp(-0.2 * std::sqrt(sumSq / n)) - std::exp(sumCos / n) + 20.0 + std::exp(1.0);
+}
+
+ALWAYS_INLINE double griewankRow(const double * x, const uint32_t n)
+{
+    const double sum = sphereRow(x, n);
+    const double product = laneProduct(n, [x](uint32_t i) { return sinOrCos(x[i] / std::sqrt(i + 1.0), true); });
+    return 1.0 + sum / 4000.0 - product;
+}
+
+ALWAYS_INLINE double schwefelRow(const double * x, const uint32_t n)
+{
+    return 418.9828872724339 * n - laneSum(n, [x](uint32_t i) { return x[i] * sinOrCos(std::sqrt(std::abs(x[i])), false); });
+}
+
+ALWAYS_INLINE double zakharovRow(const double * x, const uint32_t n)
+{
+    const double sumSq = sphereRow(x, n);
+    const double weighted = laneSum(n, [x](uint32_t i) { return 0.5 * (i + 1.0) * x[i]; });
+    const double w2 = weighted * weighted;
+    return sumSq + w2 + w2 * w2;
+}
+
+ALWAYS_INLINE double himmelblauRow(const double * x, const uint32_t n)
+{
+    return laneSum(n / 2, [x](uint32_t k)
+    {
+        const double a = x[2 * k];
+        const double b = x[2 * k + 1];
+        const double u = a * a + b - 11;
+        const double v = a + b * b - 7;
+        return u * u + v * v;
+    });
+}
+
+ALWAYS_INLINE double levi13Row(const double * x, const uint32_t n)
+{
+    const double s = sinOrCos(3 * PI * x[0], false);
+    return s * s + laneSum(n - 1, [x](uint32_t i)
+    {
+        const double sx = sinOrCos(3 * PI * x[i], false);
+        const double sy = sinOrCos(3 * PI * x[i + 1], false);
+        const double dx = x[i] - 1;
+        const double dy = x[i + 1] - 1;
+        return dx * dx * (1 + sy * sy) + dy * dy * (1 + sx * sx);
+    });
+}
+
+// =============================================
+// ============== Batch functions ==============
+// =============================================
+// One batch function per test function and instruction set
+
+#define DEFINE_BATCH(NAME, ATTRIBUTES, SUFFIX) \
+    ATTRIBUTES static void NAME##SUFFIX(const PopulationMatrix & population, double * outScores) \
+    { \
+        for (uint32_t i = 0; i < population.rows; i++) \
+            outScores[i] = NAME##Row(population.row(i), population.cols); \
+    }
+
+#ifdef OBJECTIVES_X86
+#define DEFINE_BATCHES(NAME) \
+    DEFINE_BATCH(NAME, , Scalar) \
+    DEFINE_BATCH(NAME, TARGET_AVX2, Avx2) \
+    DEFINE_BATCH(NAME, TARGET_AVX512, Avx512)
+#else
+#define DEFINE_BATCHES(NAME) DEFINE_BATCH(NAME, , Scalar)
+#endif
+
+DEFINE_BATCHES(sphere)
+DEFINE_BATCHES(ellipsoid)
+DEFINE_BATCHES(bentCigar)
+DEFINE_BATCHES(discus)
+DEFINE_BATCHES(rosenbrock)
+DEFINE_BATCHES(rastrigin)
+DEFINE_BATCHES(ackley)
+DEFINE_BATCHES(griewank)
+DEFINE_BATCHES(schwefel)
+DEFINE_BATCHES(zakharov)
+DEFINE_BATCHES(himmelblau)
+DEFINE_BATCHES(levi13)
+
+#define BATCH_TABLE(SUFFIX) \
+    { sphere##SUFFIX, ellipsoid##SUFFIX, bentCigar##SUFFIX, discus##SUFFIX, rosenbrock##SUFFIX, rastrigin##SUFFIX, \
+      ackley##SUFFIX, griewank##SUFFIX, schwefel##SUFFIX, zakharov##SUFFIX, himmelblau##SUFFIX, levi13##SUFFIX }
+
+struct BatchTable
+{
+    BatchFunction functions[TEST_FUNCTION_COUNT];
+    const char * name;
+};
+
+static BatchTable selectBatchTable()
+{
+    static const BatchTable scalar = {BATCH_TABLE(Scalar), "scalar"};
+
+#ifdef OBJECTIVES_X86
+    static const BatchTable avx2 = {BATCH_TABLE(Avx2), "avx2"};
+    static const BatchTable avx512 = {BATCH_TABLE(Avx512), "avx512"};
+
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return avx512;
+    if (__builtin_cpu_supports("avx2"))
+        return avx2;
+#endif
+
+    return scalar;
+}
+
+static const BatchTable & batchTable()
+{
+    static const BatchTable table = selectBatchTable();
+    return table;
+}
+
+// =============================================
+// ================ Public API =================
+// =============================================
+
+const TestFunctionInfo & testFunctionInfo(const TestFunction function)
+{
+    static const TestFunctionInfo infos[TEST_FUNCTION_COUNT] =
+    {
+        {"sphere",     -100,    100,    0},
+        {"ellipsoid",  -100,    100,    0},
+        {"bentCigar",  -100,    100,    0},
+        {"discus",     -100,    100,    0},
+        {"rosenbrock", -5,      10,     0},
+        {"rastrigin",  -5.12,   5.12,   0},
+        {"ackley",     -32.768, 32.768, 0},
+        {"griewank",   -600,    600,    0},
+        {"schwefel",   -500,    500,    0},
+        {"zakharov",   -5,      10,     0},
+        {"himmelblau", -5,      5,      0},
+        {"levi13",     -10,     10,     0},
+    };
+
+    const uint32_t idx = uint32_t(function);
+    if (idx >= TEST_FUNCTION_COUNT)
+    {
+        throw std::runtime_error("Unknown test function!");
+    }
+    return infos[idx];
+}
+
+BatchObjectiveFunction makeTestFunction(const TestFunction function)
+{
+    testFunctionInfo(function); // validate
+    return batchTable().functions[uint32_t(function)];
+}
+
+const char * testFunctionsIsa()
+{
+    return batchTable().name;
+}
+
+// Coordinates of the unshifted optimum
+static double optimumCoordinate(const TestFunction function, const uint32_t i)
+{
+    switch (function)
+    {
+    case TestFunction::Rosenbrock:
+    case TestFunction::Levi13:
+        return 1.0;
+    case TestFunction::Schwefel:
+        return 420.9687462275036;
+    case TestFunction::Himmelblau:
+        return i % 2 == 0 ? 3.0 : 2.0;
+    default:
+        return 0.0;
+    }
+}
+
+struct ShiftRotation
+{
+    uint32_t dimension;
+    std::vector<double> shift;    // o
+    std::vector<double> optimum;  // optimum of the unshifted function
+    std::vector<double> rotation; // M, row-major, empty -> no rotation
+    // clamp f's arguments to its domain: for functions whose minimum only holds inside it (Schwefel)
+    bool clampToDomain;
+    double xMin;
+    double xMax;
+};
+
+BatchObjectiveFunction makeShiftedTestFunction(const TestFunction function, const uint32_t dimension,
+                                               const uint64_t seed, const bool rotate, const double bias)
+{
+    const TestFunctionInfo & info = testFunctionInfo(function);
+    const BatchFunction base = batchTable().functions[uint32_t(function)];
+
+    std::shared_ptr<ShiftRotation> transform = std::make_shared<ShiftRotation>();
+    transform->dimension = dimension;
+    transform->shift.resize(dimension);
+    transform->optimum.resize(dimension);
+    // the shifted optimum is up to 0.8 * range away, so x - o + p reaches far outside the domain,
+    // where Schwefel goes below its minimum
+    transform->clampToDomain = function == TestFunction::Schwefel;
+    transform->xMin = info.xMin;
+    transform->xMax = info.xMax;
+
+    Random rng = Random::stream(seed, 0, 0);
+    for (uint32_t i = 0; i < dimension; i++)
+    {
+        transform->shift[i] = rng.uniform(0.8 * info.xMin, 0.8 * info.xMax);
+        transform->optimum[i] = optimumCoordinate(function, i);
+    }
+
+    if (rotate)
+    {
+        // Gram-Schmidt on a matrix of normal random numbers gives a uniformly random orthogonal matrix
+        std::vector<double> & m = transform->rotation;
+        m.resize(size_t(dimension) * dimension);
+        rng.fillNormal(m.data(), m.size());
+
+        for (uint32_t r = 0; r < dimension; r++)
+        {
+            double * row = &m[size_t(r) * dimension];
+            for (uint32_t k = 0; k < r; k++)
+            {
+                const double * other = &m[size_t(k) * dimension];
+                const double dot = laneSum(dimension, [row, other](uint32_t i) { return row[i] * other[i]; });
+                for (uint32_t i = 0; i < dimension; i++)
+                    row[i] -= dot * other[i];
+            }
+
+            const double norm = std::sqrt(sphereRow(row, dimension));
+            for (uint32_t i = 0; i < dimension; i++)
+                row[i] /= norm;
+        }
+    }
+
+    return [transform, base, bias](const PopulationMatrix & population, double * outScores)
+    {
+        const uint32_t n = transform->dimension;
+        if (population.cols != n)
+        {
+            throw std::runtime_error("Wrong dimension for the shifted test function!");
+        }
+
+        // transformed rows, reused between calls - the batch may be called from several threads at once
+        static thread_local std::vector<double> shifted;
+        static thread_local std::vector<double> transformed;
+        if (shifted.size() < n)
+            shifted.resize(n);
+        if (transformed.size() < size_t(population.rows) * n)
+            transformed.resize(size_t(population.rows) * n);
+
+        const double * o = transform->shift.data();
+        const double * p = transform->optimum.data();
+        for (uint32_t j = 0; j < population.rows; j++)
+        {
+            const double * x = population.row(j);
+            double * z = &transformed[size_t(j) * n];
+
+            if (transform->rotation.empty())
+            {
+                for (uint32_t i = 0; i < n; i++)
+                    z[i] = x[i] - o[i] + p[i];
+            }
+            else
+            {
+                double * d = shifted.data();
+                for (uint32_t i = 0; i < n; i++)
+                    d[i] = x[i] - o[i];
+
+                for (uint32_t r = 0; r < n; r++)
+                {
+                    const double * m = &transform->rotation[size_t(r) * n];
+                    z[r] = laneSum(n, [m, d](uint32_t i) { return m[i] * d[i]; }) + p[r];
+                }
+            }
+
+            if (transform->clampToDomain)
+            {
+                for (uint32_t i = 0; i < n; i++)
+                    z[i] = std::min(std::max(z[i], transform->xMin), transform->xMax);
+            }
+        }
+
+        PopulationMatrix rows;
+        rows.data = transformed.data();
+        rows.rows = population.rows;
+        rows.cols = n;
+        rows.stride = n;
+        base(rows, outScores);
+
+        for (uint32_t j = 0; j < population.rows; j++)
+            outScores[j] += bias;
+    };
+}
@@ -0,0 +1,259 @@
+#include "BatchSolver.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+BatchSolver::BatchSolver(uint32_t threadCount) : cancelBefore(0)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        states.emplace_back(new Worker());
+    }
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        workers.emplace_back(&BatchSolver::workerLoop, this, i);
+    }
+}
+
+BatchSolver::~BatchSolver()
+{
+    cancel();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workCondition.notify_all();
+
+    for (auto & worker : workers)
+    {
+        worker.join();
+    }
+}
+
+uint64_t BatchSolver::submit(Job job)
+{
+    if (job.xMin.size() != job.xMax.size())
+    {
+        throw std::runtime_error("xMin and xMax have different sizes!");
+    }
+
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = submitted++;
+
+        // round robin; idle workers steal from busy ones
+        Worker & worker = *states[nextWorker];
+        nextWorker = (nextWorker + 1) % states.size();
+        {
+            std::lock_guard<std::mutex> workerLock(worker.mutex);
+            worker.jobs.push_back(QueuedJob{id, std::move(job)});
+        }
+        queued++;
+    }
+    workCondition.notify_one();
+    return id;
+}
+
+bool BatchSolver::next(Result & outResult)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    resultCondition.wait(lock, [this]() { return !results.empty() || returned == submitted; });
+    if (results.empty())
+        return false;
+
+    outResult = std::move(results.front());
+    results.pop_front();
+    returned++;
+    return true;
+}
+
+void BatchSolver::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    resultCondition.wait(lock, [this]() { return finished == submitted; });
+}
+
+std::vector<BatchSolver::Result> BatchSolver::solve(std::vector<Job> jobs)
+{
+    if (callback)
+    {
+        throw std::runtime_error("solve() can't be used with a result callback!");
+    }
+
+    {
+        // next() would return their results mixed with the ones of these jobs
+        std::lock_guard<std::mutex> lock(mutex);
+        if (returned != submitted)
+        {
+            throw std::runtime_error("solve() can't be used while results of submit() are pending!");
+        }
+    }
+
+    std::vector<Result> out(jobs.size());
+    if (jobs.empty())
+        return out;
+
+    const uint64_t firstId = submit(std::move(jobs[0]));
+    for (size_t i = 1; i < jobs.size(); i++)
+    {
+        submit(std::move(jobs[i]));
+    }
+
+    Result result;
+    for (size_t i = 0; i < jobs.size();)
+    {
+        if (!next(result))
+            break;
+        // results of jobs submitted meanwhile by other threads are not ours
+        if (result.id < firstId || result.id - firstId >= jobs.size())
+            continue;
+        out[result.id - firstId] = std::move(result);
+        i++;
+    }
+    return out;
+}
+
+void BatchSolver::cancel()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    cancelBefore = submitted;
+
+    // a worker publishes runningId before it checks cancelBefore, so each job is either
+    // skipped by its worker or seen here
+    for (auto & worker : states)
+    {
+        if (worker->runningId < submitted)
+            worker->cancel = true;
+    }
+}
+
+void BatchSolver::workerLoop(const uint32_t workerIdx)
+{
+    QueuedJob job;
+    Result result;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workCondition.wait(lock, [this]() { return stopping || queued > 0; });
+            if (queued == 0)
+                return; // stopping and nothing left
+        }
+
+        // another worker can take the job first - then just wait again
+        while (takeJob(workerIdx, job))
+        {
+            runJob(workerIdx, job, result);
+            finishJob(result);
+        }
+    }
+}
+
+bool BatchSolver::takeJob(const uint32_t workerIdx, QueuedJob & outJob)
+{
+    const uint32_t workerCount = states.size();
+    bool found = false;
+
+    // newest own job first (its data is the most likely to be in cache), otherwise the oldest job of another worker
+    for (uint32_t i = 0; i < workerCount && !found; i++)
+    {
+        Worker & worker = *states[(workerIdx + i) % workerCount];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.jobs.empty())
+            continue;
+
+        if (i == 0)
+        {
+            outJob = std::move(worker.jobs.back());
+            worker.jobs.pop_back();
+        }
+        else
+        {
+            outJob = std::move(worker.jobs.front());
+            worker.jobs.pop_front();
+        }
+        found = true;
+    }
+
+    if (found)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued--;
+    }
+    return found;
+}
+
+void BatchSolver::runJob(const uint32_t workerIdx, QueuedJob & queuedJob, Result & outResult)
+{
+    Worker & worker = *states[workerIdx];
+    Job & job = queuedJob.job;
+
+    worker.cancel = false;
+    worker.runningId = queuedJob.id;
+
+    outResult.id = queuedJob.id;
+    outResult.value = 1e+99;
+    outResult.stats = Genocop::Stats();
+    outResult.error = nullptr;
+
+    if (queuedJob.id < cancelBefore)
+    {
+        outResult.solution.resize(0);
+        outResult.stats.stopReason = Genocop::StopReason::Cancelled;
+    }
+    else
+    {
+        try
+        {
+            Genocop::Options options = job.options;
+            options.threadCount = 1;
+            if (options.stop.cancel == nullptr)
+            {
+                options.stop.cancel = &worker.cancel;
+            }
+
+            const uint32_t vectorSize = job.xMin.size();
+            if (!worker.optimizer)
+            {
+                worker.optimizer.reset(new Genocop(vectorSize, job.objective, job.xMin, job.xMax));
+            }
+            else
+            {
+                worker.optimizer->setProblem(vectorSize, job.objective, job.xMin, job.xMax);
+            }
+
+            outResult.value = worker.optimizer->run(outResult.solution, options, outResult.stats);
+        }
+        catch (...)
+        {
+            outResult.error = std::current_exception();
+        }
+    }
+
+    worker.runningId = UINT64_MAX;
+}
+
+void BatchSolver::finishJob(Result & result)
+{
+    if (callback)
+    {
+        callback(result);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        finished++;
+        returned++;
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back(std::move(result));
+        finished++;
+    }
+    resultCondition.notify_all();
+}
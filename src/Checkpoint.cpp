@@ -0,0 +1,155 @@
+#include "Checkpoint.h"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint64_t alignSection(const uint64_t offset)
+{
+    return (offset + 63) / 64 * 64;
+}
+
+void checkpointLayout(CheckpointHeader & header)
+{
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+
+    header.optionsOffset = alignSection(sizeof(CheckpointHeader));
+    header.scoresOffset = alignSection(header.optionsOffset + header.optionsSize);
+    header.bestOffset = alignSection(header.scoresOffset + uint64_t(header.populationCount) * sizeof(double));
+    header.populationOffset = alignSection(header.bestOffset + uint64_t(header.vectorSize) * sizeof(double));
+    header.fileSize = header.populationOffset + uint64_t(header.populationCount) * header.vectorSize * sizeof(double);
+}
+
+// =============================================
+// ================== Writer ===================
+// =============================================
+
+CheckpointWriter::CheckpointWriter(const std::string & filename, const uint32_t interval) :
+    path(filename), every(interval > 0 ? interval : 1)
+{
+    writerThread = std::thread(&CheckpointWriter::writerLoop, this);
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    writerThread.join();
+}
+
+void CheckpointWriter::submit()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (hasPending)
+            replacedCount.fetch_add(1, std::memory_order_relaxed);
+        // the old pending buffer becomes the next front buffer - no allocation once the sizes are stable
+        front.swap(pending);
+        hasPending = true;
+    }
+    condition.notify_all();
+}
+
+void CheckpointWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [this]() { return !hasPending && !writing; });
+}
+
+void CheckpointWriter::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        condition.wait(lock, [this]() { return hasPending || stopping; });
+        if (!hasPending)
+            return; // stopping and everything written
+
+        back.swap(pending);
+        hasPending = false;
+        writing = true;
+
+        lock.unlock();
+        const bool ok = write(back);
+        lock.lock();
+
+        writing = false;
+        (ok ? writtenCount : failedCount).fetch_add(1, std::memory_order_relaxed);
+        condition.notify_all();
+    }
+}
+
+bool CheckpointWriter::write(const std::vector<char> & data)
+{
+    const std::string tmpPath = path + ".tmp";
+    FILE * file = std::fopen(tmpPath.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    // make sure the data is on disk before the old snapshot is replaced
+    ok = std::fflush(file) == 0 && ok;
+    ok = fsync(fileno(file)) == 0 && ok;
+    ok = std::fclose(file) == 0 && ok;
+
+    if (ok)
+        ok = std::rename(tmpPath.c_str(), path.c_str()) == 0;
+    else
+        std::remove(tmpPath.c_str());
+    return ok;
+}
+
+// =============================================
+// =================== Reader ==================
+// =============================================
+
+CheckpointFile::CheckpointFile(const std::string & filename)
+{
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Can't open checkpoint file " + filename);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(CheckpointHeader))
+    {
+        close(fd);
+        throw std::runtime_error("Invalid checkpoint file " + filename);
+    }
+
+    size = info.st_size;
+    void * mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        throw std::runtime_error("Can't map checkpoint file " + filename);
+    }
+    data = static_cast<const char *>(mapped);
+
+    // recompute the layout from the sizes: catches truncated files and corrupted offsets
+    CheckpointHeader expected = header();
+    checkpointLayout(expected);
+    if (std::memcmp(header().magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 ||
+        header().version != CHECKPOINT_VERSION ||
+        std::memcmp(&expected, &header(), sizeof(CheckpointHeader)) != 0 ||
+        header().fileSize != size)
+    {
+        munmap(const_cast<char *>(data), size);
+        throw std::runtime_error("Invalid checkpoint file " + filename);
+    }
+}
+
+CheckpointFile::~CheckpointFile()
+{
+    munmap(const_cast<char *>(data), size);
+}
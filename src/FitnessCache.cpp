@@ -0,0 +1,113 @@
+#include "FitnessCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+void FitnessCache::configure(const uint32_t capacity, const uint32_t vectorSize)
+{
+    uint32_t sets = 1;
+    while (sets * WAYS < capacity)
+    {
+        sets *= 2;
+    }
+
+    this->setCount = sets;
+    this->vectorSize = vectorSize;
+
+    const size_t entries = size_t(sets) * WAYS;
+    hashes.resize(entries);
+    lastUse.resize(entries);
+    values.resize(entries);
+    genomes.resize(entries * vectorSize);
+
+    clear();
+}
+
+void FitnessCache::clear()
+{
+    std::fill(lastUse.begin(), lastUse.end(), 0);
+    clock = 0;
+    statistics = Stats();
+}
+
+bool FitnessCache::lookup(const double * genome, double & outValue)
+{
+    if (setCount == 0)
+    {
+        statistics.misses++;
+        return false;
+    }
+
+    const uint64_t h = hash(genome);
+    const int64_t entry = find(genome, h);
+    if (entry < 0)
+    {
+        statistics.misses++;
+        return false;
+    }
+
+    statistics.hits++;
+    lastUse[entry] = ++clock;
+    outValue = values[entry];
+    return true;
+}
+
+void FitnessCache::insert(const double * genome, const double value)
+{
+    if (setCount == 0)
+        return;
+
+    const uint64_t h = hash(genome);
+    int64_t entry = find(genome, h);
+    if (entry < 0)
+    {
+        // empty or least recently used way of the set
+        const size_t first = size_t(h & (setCount - 1)) * WAYS;
+        entry = first;
+        for (size_t i = first + 1; i < first + WAYS; i++)
+        {
+            if (lastUse[i] < lastUse[entry])
+                entry = i;
+        }
+
+        if (lastUse[entry] != 0)
+            statistics.evictions++;
+        statistics.insertions++;
+
+        hashes[entry] = h;
+        std::memcpy(&genomes[size_t(entry) * vectorSize], genome, vectorSize * sizeof(double));
+    }
+
+    values[entry] = value;
+    lastUse[entry] = ++clock;
+}
+
+uint64_t FitnessCache::hash(const double * genome) const
+{
+    // FNV-1a over 64-bit words, followed by a SplitMix64 finalizer to spread the bits used for the set index
+    uint64_t h = 0xcbf29ce484222325;
+    for (uint32_t i = 0; i < vectorSize; i++)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, genome + i, sizeof(bits));
+        h = (h ^ bits) * 0x100000001b3;
+    }
+
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111eb;
+    return h ^ (h >> 31);
+}
+
+int64_t FitnessCache::find(const double * genome, const uint64_t h) const
+{
+    const size_t first = size_t(h & (setCount - 1)) * WAYS;
+    for (size_t i = first; i < first + WAYS; i++)
+    {
+        if (lastUse[i] != 0 && hashes[i] == h &&
+            std::memcmp(&genomes[i * vectorSize], genome, vectorSize * sizeof(double)) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -1,16 +1,40 @@
 #include "Genocop.h"
 
 #include <algorithm>
-#include <iostream>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <mutex>
 
 Genocop::Genocop(const uint32_t vectorSize, ObjectiveFunction objective, 
+            const Vector xMin, const Vector xMax) :
+                Genocop(vectorSize, makeBatchObjective(objective), xMin, xMax)
+{
+}
+
+Genocop::Genocop(const uint32_t vectorSize, BatchObjectiveFunction objective, 
             const Vector xMin, const Vector xMax) : 
-                objFunction(objective), vectorSize(vectorSize),
-                pRng(0, 1), mRng(-1, 1), cRng(1, vectorSize - 1), 
-                xMin(xMin), xMax(xMax)
+                vectorSize(0), kernels(Kernels::get())
+{
+    setProblem(vectorSize, objective, xMin, xMax);
+}
+
+void Genocop::setProblem(const uint32_t vectorSize, BatchObjectiveFunction objective,
+                         const Vector & xMin, const Vector & xMax)
 {
-    this->offsetX.resize(vectorSize);
-    this->scaleX.resize(vectorSize);
+    this->objFunction = objective;
+    this->vectorSize = vectorSize;
+    this->xMin = xMin;
+    this->xMax = xMax;
+    this->constraints = LinearConstraints(vectorSize);
+
+    if (this->offsetX.size() != vectorSize)
+    {
+        this->offsetX.resize(vectorSize);
+        this->scaleX.resize(vectorSize);
+    }
 
     // compute scales and offsets for subsequent runs
     for (uint32_t i = 0; i < vectorSize; i++)
@@ -18,17 +42,67 @@ Genocop::Genocop(const uint32_t vectorSize, ObjectiveFunction objective,
         offsetX[i] = 0.5 * (xMin[i] + xMax[i]);
         scaleX[i] = 0.5 * (xMax[i] - xMin[i]);
     }
-
-    // seed the rng
-    this->randomEngine.seed(std::chrono::system_clock::now().time_since_epoch().count());
 }
 
 double Genocop::run(Vector & outSolution, Genocop::Options options)
+{
+    start(options);
+    saveCheckpoint();
+
+    // main optimization loop
+    while (checkStop() == StopReason::None)
+    {
+        step();
+        saveCheckpoint();
+    }
+    polishBest();
+
+    outSolution = bestSolution;
+    return bestScore;
+}
+
+double Genocop::resume(const std::string & filename, Vector & outSolution, const std::atomic<bool> * cancel)
+{
+    restore(filename, cancel);
+
+    while (checkStop() == StopReason::None)
+    {
+        step();
+        saveCheckpoint();
+    }
+    polishBest();
+
+    outSolution = bestSolution;
+    return bestScore;
+}
+
+double Genocop::run(Vector & outSolution, Genocop::Options options, Genocop::Stats & outStats)
+{
+    const double result = run(outSolution, options);
+    outStats = stats();
+    return result;
+}
+
+Genocop::Stats Genocop::stats() const
+{
+    Stats result;
+    result.iterations = iteration;
+    result.evaluations = evaluationCount;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    result.stopReason = stopCause;
+#ifdef GENOCOP_PROFILE
+    result.profiled = true;
+    std::copy(profileTotal, profileTotal + PROFILE_PHASE_COUNT, result.total);
+    std::copy(profileLastGeneration, profileLastGeneration + PROFILE_PHASE_COUNT, result.lastGeneration);
+#endif
+    return result;
+}
+
+void Genocop::initRun(Genocop::Options options)
 {
     const uint32_t VECTOR_SIZE = this->vectorSize;
     const uint32_t POPULATION_COUNT = options.populationCount;
     const uint32_t PARENTS_COUNT = options.parentsCount;
-    const uint32_t MAX_ITERS = options.maxIters;
 
     // Sanity check (make options sensible)
     {
@@ -59,171 +133,1218 @@ double Genocop::run(Vector & outSolution, Genocop::Options options)
         }
     }
 
+    this->runOptions = options;
+    this->iteration = 0;
+
+    // seed the rng
+    this->runSeed = options.seed;
+    if (this->runSeed == 0)
+    {
+        this->runSeed = std::chrono::system_clock::now().time_since_epoch().count();
+    }
+
+    // Start the worker pool (if needed) before the main loop so it's reused by every iteration
+    this->activePool = nullptr;
+    if (options.threadCount != 1)
+    {
+        const uint32_t threadCount = options.threadCount > 0 ? options.threadCount : std::max(1u, std::thread::hardware_concurrency());
+        if (!this->threadPool || this->threadPool->size() != threadCount)
+        {
+            this->threadPool.reset(new ThreadPool(threadCount));
+        }
+        this->activePool = this->threadPool.get();
+    }
+
     // Allocate just once - save time
-    std::vector<Vector> population(POPULATION_COUNT);
-    std::vector<Score> parents(PARENTS_COUNT);
-    std::vector<Score> scores(POPULATION_COUNT);
+    // (the matrices keep their memory between runs)
+    population.resize(POPULATION_COUNT, VECTOR_SIZE);
+    children.resize(POPULATION_COUNT, VECTOR_SIZE);
+    scores.resize(POPULATION_COUNT);
+    parents.resize(PARENTS_COUNT);
+    plan.resize(POPULATION_COUNT);
 
-    // allocate parents
-    for (uint32_t i = 0; i < PARENTS_COUNT; i++)
+    const uint32_t threadCount = this->activePool != nullptr ? this->activePool->size() : 1;
+    directions.resize(threadCount);
+    for (auto & dir : directions)
     {
-        parents[i].x.resize(VECTOR_SIZE); 
+        if (dir.size() != VECTOR_SIZE)
+            dir.resize(VECTOR_SIZE);
     }
 
-    // create first population
-    for (uint32_t i = 0; i < POPULATION_COUNT; i++)
+    runStart = std::chrono::steady_clock::now();
+    busyNanoseconds.assign(threadCount, 0);
+    counters.assign(threadCount, OperatorCounters());
+#ifdef GENOCOP_PROFILE
+    profileCounters.assign(threadCount, ProfileCounters());
+    std::fill(profileTotal, profileTotal + PROFILE_PHASE_COUNT, PhaseStats());
+    std::fill(profileLastGeneration, profileLastGeneration + PROFILE_PHASE_COUNT, PhaseStats());
+#endif
+    busyAtLastRecord = 0;
+    selectionSeconds = 0;
+
+    bestScore = 1e+99;
+    notifiedBest = 1e+99;
+    if (bestSolution.size() != VECTOR_SIZE)
+        bestSolution.resize(VECTOR_SIZE);
+    evaluationCount = 0;
+
+    stopCause = StopReason::None;
+    stallBest = 1e+99;
+    stallIteration = 0;
+    diversity = 0;
+    if ((options.stop.minDiversity > 0 || this->telemetry != nullptr) && geneMean.size() != VECTOR_SIZE)
+    {
+        geneMean.resize(VECTOR_SIZE);
+        geneVariance.resize(VECTOR_SIZE);
+    }
+
+    if (options.localSearch.interval > 0 || options.localSearch.polishEvaluations > 0)
+    {
+        localSearchers.resize(threadCount);
+        localSearchStep.resize(VECTOR_SIZE);
+    }
+
+    if (options.cache.capacity > 0)
     {
-        // allocate scores and individuals        
-        scores[i].x.resize(VECTOR_SIZE);
-        Vector & individual = population[i];
-        individual.resize(VECTOR_SIZE);
-        for (uint32_t j = 0; j < VECTOR_SIZE; j++)
+        fitnessCache.configure(options.cache.capacity, VECTOR_SIZE);
+        missIdx.reserve(POPULATION_COUNT);
+        missRows.resize(POPULATION_COUNT, VECTOR_SIZE);
+        missScores.resize(POPULATION_COUNT);
+    }
+    else
+    {
+        fitnessCache.configure(0, VECTOR_SIZE);
+    }
+}
+
+void Genocop::start(Genocop::Options options)
+{
+    initRun(options);
+    initialPopulation();
+
+    calculateScores();
+    collectProfile();
+}
+
+void Genocop::setSeeds(const std::vector<Vector> & solutions)
+{
+    const uint32_t cols = solutions.empty() ? 0 : solutions[0].size();
+    seedRows.resize(solutions.size(), cols);
+    for (uint32_t j = 0; j < solutions.size(); j++)
+    {
+        if (solutions[j].size() != cols)
         {
-            // first generation is random
-            individual[j] = this->offsetX[j] + this->scaleX[j] * getMutation();
+            throw std::runtime_error("Seeds of different sizes!");
         }
+        std::copy(std::begin(solutions[j]), std::end(solutions[j]), seedRows.row(j));
     }
+}
 
-    double bestScore = 1e+99;
-    uint32_t bestIdx = 0;
-    double averageScore = 0;
+void Genocop::setSeeds(const GenomeMatrix & rows)
+{
+    seedRows.resize(rows.rows(), rows.cols());
+    for (uint32_t j = 0; j < rows.rows(); j++)
+    {
+        std::copy(rows.row(j), rows.row(j) + rows.cols(), seedRows.row(j));
+    }
+}
 
-    auto calculateScores = [&]()
+void Genocop::clearSeeds()
+{
+    seedRows.resize(0, 0);
+}
+
+void Genocop::setConstraints(const LinearConstraints & constraints)
+{
+    if (constraints.vectorSize() != vectorSize)
     {
-        averageScore = 0;
+        throw std::runtime_error("Constraints of a different vector size!");
+    }
+    this->constraints = constraints;
+    this->constraints.prepare(xMin, xMax);
+}
 
-        // calculate scores
-        for (uint32_t j = 0; j < POPULATION_COUNT; j++)
+void Genocop::clearConstraints()
+{
+    constraints = LinearConstraints(vectorSize);
+}
+
+void Genocop::initialPopulation()
+{
+    const uint32_t VECTOR_SIZE = this->vectorSize;
+    const uint32_t POPULATION_COUNT = population.rows();
+    const auto & init = runOptions.init;
+
+    // =============================================
+    // ================= Warm start ================
+    // =============================================
+
+    const uint32_t SEED_COUNT = seedRows.rows();
+    uint32_t seeded = 0;
+    if (SEED_COUNT > 0)
+    {
+        if (seedRows.cols() != VECTOR_SIZE)
         {
-            scores[j].x = population[j];
-            scores[j].value = this->objFunction(population[j]); 
+            throw std::runtime_error("Seeds of a different vector size!");
+        }
+        seeded = std::min(POPULATION_COUNT, uint32_t(std::max(0.0, init.seedFraction) * POPULATION_COUNT + 0.5));
+    }
 
-            if (scores[j].value < bestScore)
+    // the seeds in turn: first exact copies, then perturbed ones
+    parallelFor(seeded, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            const double * seed = seedRows.row(i % SEED_COUNT);
+            double * x = population.row(i);
+            const bool perturb = i >= SEED_COUNT && init.perturbation > 0;
+            Random rng = getStream(0, STREAM_INIT, i);
+            for (uint32_t k = 0; k < VECTOR_SIZE; k++)
             {
-                bestScore = scores[j].value;
-                bestIdx = j;
+                double value = seed[k];
+                if (perturb)
+                    value += rng.normal() * init.perturbation * 2 * scaleX[k];
+                x[k] = std::min(std::max(value, xMin[k]), xMax[k]);
             }
-            averageScore += scores[j].value;
         }
+    });
 
-        averageScore /= POPULATION_COUNT;
+    // =============================================
+    // ================ Sampled rows ===============
+    // =============================================
+
+    const uint32_t SAMPLED_COUNT = POPULATION_COUNT - seeded;
+    switch (init.method)
+    {
+    case Initialization::Uniform:
+        parallelFor(SAMPLED_COUNT, [&](uint32_t begin, uint32_t end, uint32_t)
+        {
+            for (uint32_t i = seeded + begin; i < seeded + end; i++)
+            {
+                Random rng = getStream(0, STREAM_INIT, i);
+                fullRangeMutation(population.row(i), rng);
+            }
+        });
+        break;
+
+    case Initialization::LatinHypercube:
+        // one column at a time: a random permutation of the slices, a random point inside each slice
+        parallelFor(VECTOR_SIZE, [&](uint32_t begin, uint32_t end, uint32_t)
+        {
+            std::vector<uint32_t> slices(SAMPLED_COUNT);
+            for (uint32_t k = begin; k < end; k++)
+            {
+                Random rng = getStream(0, STREAM_GENE, k);
+                for (uint32_t j = 0; j < SAMPLED_COUNT; j++)
+                    slices[j] = j;
+                for (uint32_t j = SAMPLED_COUNT; j > 1; j--)
+                    std::swap(slices[j - 1], slices[rng.index(j)]);
+
+                for (uint32_t j = 0; j < SAMPLED_COUNT; j++)
+                {
+                    const double u = (slices[j] + rng.uniform()) / SAMPLED_COUNT;
+                    population.row(seeded + j)[k] = offsetX[k] + scaleX[k] * (2 * u - 1);
+                }
+            }
+        });
+        break;
+
+    case Initialization::Sobol:
+        if (!sobol || sobol->dimension() != VECTOR_SIZE)
+        {
+            sobol.reset(new SobolSequence(VECTOR_SIZE));
+        }
+        // a random digital shift per gene: different seeds give different points with the same uniformity
+        parallelFor(VECTOR_SIZE, [&](uint32_t begin, uint32_t end, uint32_t)
+        {
+            for (uint32_t k = begin; k < end; k++)
+            {
+                Random rng = getStream(0, STREAM_GENE, k);
+                const uint32_t shift = uint32_t(rng() >> 32);
+                for (uint32_t j = 0; j < SAMPLED_COUNT; j++)
+                {
+                    const double u = ((sobol->coordinate(j, k) ^ shift) + 0.5) * (1.0 / 4294967296.0);
+                    population.row(seeded + j)[k] = offsetX[k] + scaleX[k] * (2 * u - 1);
+                }
+            }
+        });
+        break;
+    }
+
+    // =============================================
+    // ================ Constraints ================
+    // =============================================
+
+    if (!constraints.empty())
+    {
+        // random points between the interior point and the rows, so that the population spreads over the feasible region
+        parallelFor(POPULATION_COUNT, [&](uint32_t begin, uint32_t end, uint32_t)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                Random rng = getStream(0, STREAM_REPAIR, i);
+                repair(population.row(i), constraints.interiorPoint(), true, rng);
+            }
+        });
+    }
+}
+
+void Genocop::refineElites()
+{
+    GENOCOP_PROFILE_SCOPE(profileCounters[0], ProfilePhase::LocalSearch);
+
+    const uint32_t VECTOR_SIZE = this->vectorSize;
+    const uint32_t POPULATION_COUNT = population.rows();
+    const auto & localSearch = runOptions.localSearch;
+    const uint32_t budget = localSearch.maxEvaluations > 0 ? localSearch.maxEvaluations : 20 * (VECTOR_SIZE + 1);
 
-        if (this->callback != 0)
-            callback(scores);
+    updateLocalSearchStep();
+
+    // best first, ties by index; exact copies (elite children) are refined only once
+    sortScratch.resize(POPULATION_COUNT);
+    for (uint32_t i = 0; i < POPULATION_COUNT; i++)
+        sortScratch[i] = i;
+    std::sort(sortScratch.begin(), sortScratch.end(), [&](uint32_t a, uint32_t b)
+    {
+        return scores[a] < scores[b] || (scores[a] == scores[b] && a < b);
+    });
+
+    refineRows.clear();
+    for (uint32_t i = 0; i < POPULATION_COUNT && refineRows.size() < localSearch.eliteCount; i++)
+    {
+        const double * candidate = population.row(sortScratch[i]);
+        bool duplicate = false;
+        for (auto row : refineRows)
+        {
+            if (std::equal(candidate, candidate + VECTOR_SIZE, population.row(row)))
+            {
+                duplicate = true;
+                break;
+            }
+        }
+        if (!duplicate)
+            refineRows.push_back(sortScratch[i]);
+    }
+
+    // budgets within stop.maxEvaluations as if every refinement used all of its budget, best individuals first.
+    // refineEvaluations holds the budget of each individual, then its evaluations
+    const uint64_t maxEvaluations = runOptions.stop.maxEvaluations;
+    uint64_t left = maxEvaluations > evaluationCount ? maxEvaluations - evaluationCount : 0;
+    refineEvaluations.assign(refineRows.size(), budget);
+    for (uint32_t e = 0; e < refineRows.size() && maxEvaluations > 0; e++)
+    {
+        if (left == 0)
+        {
+            refineRows.resize(e);
+            refineEvaluations.resize(e);
+            break;
+        }
+        refineEvaluations[e] = uint32_t(std::min<uint64_t>(budget, left));
+        left -= refineEvaluations[e];
+    }
+
+    // one individual per task: the result doesn't depend on the thread count
+    parallelFor(refineRows.size(), [this](uint32_t begin, uint32_t end, uint32_t threadIdx)
+    {
+        for (uint32_t e = begin; e < end; e++)
+        {
+            const uint32_t row = refineRows[e];
+            refineEvaluations[e] = localMinimize(threadIdx, population.row(row), scores[row], &localSearchStep[0],
+                                                 refineEvaluations[e]);
+        }
+    }, 1);
+
+    for (auto count : refineEvaluations)
+        evaluationCount += count;
+}
+
+void Genocop::updateLocalSearchStep()
+{
+    const uint32_t VECTOR_SIZE = this->vectorSize;
+    const uint32_t POPULATION_COUNT = population.rows();
+    const double maxStep = 2.0 * runOptions.localSearch.initialStep;
+
+    // spread of the best tenth of the population (full range mutations would dominate the whole one)
+    const uint32_t BEST_COUNT = std::min(POPULATION_COUNT, std::max(2u, POPULATION_COUNT / 10));
+    sortScratch.resize(POPULATION_COUNT);
+    for (uint32_t i = 0; i < POPULATION_COUNT; i++)
+        sortScratch[i] = i;
+    std::partial_sort(sortScratch.begin(), sortScratch.begin() + BEST_COUNT, sortScratch.end(), [&](uint32_t a, uint32_t b)
+    {
+        return scores[a] < scores[b] || (scores[a] == scores[b] && a < b);
+    });
+
+    // standard deviation of each gene, limited to [1e-12, initialStep] of the range
+    for (uint32_t k = 0; k < VECTOR_SIZE; k++)
+    {
+        double mean = 0;
+        for (uint32_t j = 0; j < BEST_COUNT; j++)
+            mean += population.row(sortScratch[j])[k];
+        mean /= BEST_COUNT;
+
+        double variance = 0;
+        for (uint32_t j = 0; j < BEST_COUNT; j++)
+        {
+            const double d = population.row(sortScratch[j])[k] - mean;
+            variance += d * d;
+        }
+        const double deviation = std::sqrt(variance / BEST_COUNT);
+        localSearchStep[k] = std::min(std::max(deviation, 2e-12 * scaleX[k]), maxStep * scaleX[k]);
+    }
+}
+
+void Genocop::polishBest()
+{
+    // the caller asked to stop now
+    if (stopCause == StopReason::Cancelled || stopCause == StopReason::TimeLimit)
+        return;
+
+    uint64_t budget = runOptions.localSearch.polishEvaluations;
+    const uint64_t maxEvaluations = runOptions.stop.maxEvaluations;
+    if (maxEvaluations > 0)
+        budget = evaluationCount < maxEvaluations ? std::min(budget, maxEvaluations - evaluationCount) : 0;
+    if (budget == 0)
+        return;
+
+    GENOCOP_PROFILE_SCOPE(profileCounters[0], ProfilePhase::LocalSearch);
+    // a large simplex: the budget is usually large enough to shrink it, and a small one crawls
+    // when the solution is still far from the minimum
+    localSearchStep = 2.0 * runOptions.localSearch.initialStep * scaleX;
+    evaluationCount += localMinimize(0, &bestSolution[0], bestScore, &localSearchStep[0], uint32_t(budget));
+    collectProfile();
+}
+
+uint32_t Genocop::localMinimize(const uint32_t threadIdx, double * x, double & value, const double * step,
+                                const uint32_t maxEvaluations)
+{
+    const uint32_t VECTOR_SIZE = this->vectorSize;
+    LocalSearcher & searcher = localSearchers[threadIdx];
+
+    if (constraints.empty())
+    {
+        const BatchObjectiveFunction objective = [this, threadIdx](const PopulationMatrix & rows, double * outScores)
+        {
+            evaluate(rows, outScores, threadIdx);
+        };
+        return searcher.nelderMead.minimize(objective, x, value, &xMin[0], &xMax[0], step, VECTOR_SIZE, maxEvaluations);
+    }
+
+    // search the free variables; the pivots follow them, and infeasible trial points get an infinite value
+    // without calling the objective
+    const std::vector<uint32_t> & freeIdx = constraints.freeVariables();
+    const uint32_t FREE_COUNT = freeIdx.size();
+    if (searcher.x.size() != FREE_COUNT)
+    {
+        searcher.x.resize(FREE_COUNT);
+        searcher.xMin.resize(FREE_COUNT);
+        searcher.xMax.resize(FREE_COUNT);
+        searcher.step.resize(FREE_COUNT);
+    }
+    for (uint32_t k = 0; k < FREE_COUNT; k++)
+    {
+        searcher.x[k] = x[freeIdx[k]];
+        searcher.xMin[k] = xMin[freeIdx[k]];
+        searcher.xMax[k] = xMax[freeIdx[k]];
+        searcher.step[k] = step[freeIdx[k]];
+    }
+
+    uint32_t evaluations = 0;
+    const BatchObjectiveFunction objective = [&](const PopulationMatrix & rows, double * outScores)
+    {
+        searcher.expanded.resize(rows.rows, VECTOR_SIZE);
+        searcher.feasibleRows.clear();
+        for (uint32_t j = 0; j < rows.rows; j++)
+        {
+            double * full = searcher.expanded.row(searcher.feasibleRows.size());
+            for (uint32_t k = 0; k < FREE_COUNT; k++)
+                full[freeIdx[k]] = rows.row(j)[k];
+            constraints.complete(full);
+
+            if (constraints.feasible(full))
+            {
+                constraints.clampToBox(full);
+                searcher.feasibleRows.push_back(j);
+            }
+            else
+                outScores[j] = std::numeric_limits<double>::infinity();
+        }
+
+        const uint32_t FEASIBLE_COUNT = searcher.feasibleRows.size();
+        if (FEASIBLE_COUNT == 0)
+            return;
+        searcher.feasibleScores.resize(FEASIBLE_COUNT);
+        evaluate(searcher.expanded.view(0, FEASIBLE_COUNT), &searcher.feasibleScores[0], threadIdx);
+        for (uint32_t i = 0; i < FEASIBLE_COUNT; i++)
+            outScores[searcher.feasibleRows[i]] = searcher.feasibleScores[i];
+        evaluations += FEASIBLE_COUNT;
     };
+    searcher.nelderMead.minimize(objective, &searcher.x[0], value, &searcher.xMin[0], &searcher.xMax[0],
+                                 &searcher.step[0], FREE_COUNT, maxEvaluations);
 
-    // main optimization loop
-    for (uint32_t i = 0; i < MAX_ITERS; i++)
+    // the same free values give the same completed genome as the evaluated one
+    for (uint32_t k = 0; k < FREE_COUNT; k++)
+        x[freeIdx[k]] = searcher.x[k];
+    constraints.complete(x);
+    constraints.clampToBox(x);
+    return evaluations;
+}
+
+void Genocop::repair(double * x, const double * feasible, const bool randomStep, Random & rng) const
+{
+    const uint32_t VECTOR_SIZE = this->vectorSize;
+
+    constraints.complete(x);
+    if (!constraints.feasible(x))
+    {
+        // the feasible region is convex: the segment is feasible up to maxStep
+        double t = constraints.maxStep(feasible, x);
+        if (randomStep)
+            t *= rng.uniform();
+        for (uint32_t k = 0; k < VECTOR_SIZE; k++)
+            x[k] = feasible[k] + t * (x[k] - feasible[k]);
+        constraints.complete(x);
+    }
+    constraints.clampToBox(x);
+}
+
+void Genocop::restore(const std::string & filename, const std::atomic<bool> * cancel)
+{
+    static_assert(std::is_trivially_copyable<Options>::value, "Options are saved as raw bytes");
+
+    const CheckpointFile file(filename);
+    const CheckpointHeader & header = file.header();
+    if (header.optionsSize != sizeof(Options))
+    {
+        throw std::runtime_error("Checkpoint written by a different build: " + filename);
+    }
+    if (header.vectorSize != this->vectorSize)
     {
-        calculateScores();
-        std::cout << i << "\t" << bestScore << "\t" << averageScore << "\n";
+        throw std::runtime_error("Checkpoint of a problem with a different vector size: " + filename);
+    }
+
+    Options options;
+    std::memcpy(&options, file.options(), sizeof(Options));
+    options.seed = header.seed;
+    options.stop.cancel = cancel;
+    if (options.populationCount != header.populationCount)
+    {
+        throw std::runtime_error("Invalid checkpoint file " + filename);
+    }
 
-        selectParents(scores, parents, options.tournament.size, options.tournament.p);
-        createChildren(scores, parents, population, options, i);
+    initRun(options);
+
+    const uint32_t VECTOR_SIZE = this->vectorSize;
+    for (uint32_t j = 0; j < header.populationCount; j++)
+    {
+        std::copy(file.row(j), file.row(j) + VECTOR_SIZE, population.row(j));
     }
+    std::copy(file.scores(), file.scores() + header.populationCount, scores.begin());
+    std::copy(file.bestSolution(), file.bestSolution() + VECTOR_SIZE, std::begin(bestSolution));
+
+    iteration = header.iteration;
+    evaluationCount = header.evaluations;
+    bestScore = header.bestValue;
+    notifiedBest = header.bestValue;
+    stallBest = header.stallBest;
+    stallIteration = header.stallIteration;
+    runStart -= std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(header.elapsedSeconds));
+
+    double sum = 0;
+    for (auto score : scores)
+        sum += score;
+    averageScore = sum / header.populationCount;
+
+    // diversity for the stopping criteria (stallBest is already up to date)
+    updateProgress();
+}
+
+void Genocop::saveCheckpoint()
+{
+    if (checkpoint == nullptr || iteration % checkpoint->interval() != 0)
+        return;
+
+    const uint32_t VECTOR_SIZE = this->vectorSize;
+    const uint32_t POPULATION_COUNT = population.rows();
 
+    CheckpointHeader header = CheckpointHeader();
+    header.optionsSize = sizeof(Options);
+    header.vectorSize = VECTOR_SIZE;
+    header.populationCount = POPULATION_COUNT;
+    header.iteration = iteration;
+    header.stallIteration = stallIteration;
+    header.seed = runSeed;
+    header.evaluations = evaluationCount;
+    header.bestValue = bestScore;
+    header.stallBest = stallBest;
+    header.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    checkpointLayout(header);
+
+    // the padding between the sections is written as zeros
+    std::vector<char> & buffer = checkpoint->buffer();
+    buffer.assign(header.fileSize, 0);
+    char * data = buffer.data();
+
+    Options options = runOptions;
+    options.stop.cancel = nullptr;
+    std::memcpy(data, &header, sizeof(header));
+    std::memcpy(data + header.optionsOffset, &options, sizeof(options));
+    std::memcpy(data + header.scoresOffset, scores.data(), POPULATION_COUNT * sizeof(double));
+    std::memcpy(data + header.bestOffset, &bestSolution[0], VECTOR_SIZE * sizeof(double));
+
+    double * rows = reinterpret_cast<double *>(data + header.populationOffset);
+    for (uint32_t j = 0; j < POPULATION_COUNT; j++)
+    {
+        std::memcpy(rows + size_t(j) * VECTOR_SIZE, population.row(j), VECTOR_SIZE * sizeof(double));
+    }
+
+    checkpoint->submit();
+}
+
+void Genocop::step()
+{
+    {
+        GENOCOP_PROFILE_SCOPE(profileCounters[0], ProfilePhase::SelectParents);
+        if (this->telemetry != nullptr)
+        {
+            const auto selectionStart = std::chrono::steady_clock::now();
+            selectParents(scores, parents, runOptions, iteration);
+            selectionSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - selectionStart).count();
+        }
+        else
+        {
+            selectParents(scores, parents, runOptions, iteration);
+        }
+    }
+    createChildren(population, scores, parents, children, runOptions, iteration);
+    population.swap(children);
+
+    iteration++;
     calculateScores();
-    std::cout << MAX_ITERS << "\t" << bestScore << "\t" << averageScore << "\n";
+    collectProfile();
+}
 
-    outSolution = scores[bestIdx].x;
-    return bestScore;
+void Genocop::collectProfile()
+{
+#ifdef GENOCOP_PROFILE
+    for (uint32_t p = 0; p < PROFILE_PHASE_COUNT; p++)
+    {
+        PhaseStats generation;
+        for (auto & threadCounters : profileCounters)
+        {
+            generation.calls += threadCounters.phases[p].calls;
+            generation.nanoseconds += threadCounters.phases[p].nanoseconds;
+            threadCounters.phases[p] = PhaseStats();
+        }
+        profileLastGeneration[p] = generation;
+        profileTotal[p].calls += generation.calls;
+        profileTotal[p].nanoseconds += generation.nanoseconds;
+    }
+#endif
 }
 
-void Genocop::selectParents(const std::vector<Score> & scores, std::vector<Score> & outParents,
-                            const uint32_t tournamentSize, const double tournamentP)
+void Genocop::calculateScores()
 {
-    const uint32_t SCORES_COUNT = scores.size();
+    const uint32_t VECTOR_SIZE = this->vectorSize;
+    const uint32_t POPULATION_COUNT = population.rows();
 
-    // check if the index vector is the proper size
-    {        
-        if (scoreIdx.size() != SCORES_COUNT)
+    averageScore = 0;
+
+    // calculate scores
+    {
+        GENOCOP_PROFILE_SCOPE(profileCounters[0], ProfilePhase::CalculateScores);
+        if (runOptions.cache.capacity > 0)
         {
-            scoreIdx.resize(SCORES_COUNT);
-            for (uint32_t i = 0; i < SCORES_COUNT; i++)
-                scoreIdx[i] = i;
+            calculateScoresCached();
+        }
+        else
+        {
+            parallelFor(POPULATION_COUNT, [this](uint32_t begin, uint32_t end, uint32_t threadIdx)
+            {
+                evaluate(this->population.view(begin, end), this->scores.data() + begin, threadIdx);
+            });
+            evaluationCount += POPULATION_COUNT;
         }
     }
-    
-    std::uniform_int_distribution<uint32_t> idxRng(0, 137137137);
-    auto & rng = this->randomEngine;
 
-    // comparison function
-    auto scoreIdxCompare = [&](uint32_t a, uint32_t b) -> bool
+    // refine before the best solution is updated, so that it sees the refined individuals
+    const uint32_t localSearchInterval = runOptions.localSearch.interval;
+    if (localSearchInterval > 0 && iteration > 0 && iteration % localSearchInterval == 0)
     {
-        return scores[a] < scores[b];
-    };
+        refineElites();
+    }
 
-    auto runTournament = [&]() -> uint32_t
+    // find the best in index order - same result regardless of evaluation order
+    uint32_t bestIdx = POPULATION_COUNT;
+    for (uint32_t j = 0; j < POPULATION_COUNT; j++)
     {
-        // shuffle the first tournamentSize indices
-        for (uint32_t i = 0; i < tournamentSize; i++)
+        if (scores[j] < bestScore)
         {
-            // choose an element to swap with that has a higher idx than the current element
-            const uint32_t swapIdx = idxRng(rng) % (SCORES_COUNT - i) + i;
-            std::swap(scoreIdx[i], scoreIdx[swapIdx]);
+            bestScore = scores[j];
+            bestIdx = j;
         }
+        averageScore += scores[j];
+    }
+
+    // keep a copy: the best individual may not survive to the next generation
+    if (bestIdx < POPULATION_COUNT)
+    {
+        const double * best = population.row(bestIdx);
+        std::copy(best, best + VECTOR_SIZE, std::begin(bestSolution));
+    }
+
+    averageScore /= POPULATION_COUNT;
+
+    updateProgress();
+    if (this->telemetry != nullptr)
+        recordGeneration();
+    notifyCallback();
+}
+
+void Genocop::updateProgress()
+{
+    const auto & stop = runOptions.stop;
+
+    if (bestScore < stallBest - stop.stallTolerance)
+    {
+        stallBest = bestScore;
+        stallIteration = iteration;
+    }
+
+    if (stop.minDiversity > 0 || this->telemetry != nullptr)
+    {
+        const uint32_t VECTOR_SIZE = this->vectorSize;
+        const uint32_t POPULATION_COUNT = population.rows();
 
-        // sort the first elements according to their representitive values
-        std::sort(scoreIdx.begin(), scoreIdx.begin() + tournamentSize, scoreIdxCompare);
+        // two passes over the rows: means, then variances
+        geneMean = 0.0;
+        geneVariance = 0.0;
+        for (uint32_t j = 0; j < POPULATION_COUNT; j++)
+        {
+            const double * row = population.row(j);
+            for (uint32_t i = 0; i < VECTOR_SIZE; i++)
+                geneMean[i] += row[i];
+        }
+        geneMean /= double(POPULATION_COUNT);
 
-        // decide the winner
-        for (uint32_t i = 0; i < tournamentSize - 1; i++)
+        for (uint32_t j = 0; j < POPULATION_COUNT; j++)
         {
-            const double p = getProbability();
-            if (p < tournamentP)
+            const double * row = population.row(j);
+            for (uint32_t i = 0; i < VECTOR_SIZE; i++)
             {
-                return scoreIdx[i];
+                const double d = row[i] - geneMean[i];
+                geneVariance[i] += d * d;
             }
         }
 
-        // if we are here then none of the previous tournament participants won
-        // so the last participant is the winner
-        return scoreIdx[tournamentSize - 1];
+        double sum = 0;
+        for (uint32_t i = 0; i < VECTOR_SIZE; i++)
+        {
+            // scaleX is half of the range
+            sum += std::sqrt(geneVariance[i] / POPULATION_COUNT) / (2 * scaleX[i]);
+        }
+        diversity = sum / VECTOR_SIZE;
+    }
+}
+
+void Genocop::recordGeneration()
+{
+    const uint32_t POPULATION_COUNT = population.rows();
+
+    GenerationRecord record;
+    record.iteration = iteration;
+    record.evaluations = evaluationCount;
+    record.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    record.best = bestScore;
+    record.diversity = diversity;
+
+    double sum = 0;
+    for (uint32_t j = 0; j < POPULATION_COUNT; j++)
+        sum += scores[j];
+    record.mean = sum / POPULATION_COUNT;
+
+    double sumSq = 0;
+    for (uint32_t j = 0; j < POPULATION_COUNT; j++)
+    {
+        const double d = scores[j] - record.mean;
+        sumSq += d * d;
+    }
+    record.stddev = std::sqrt(sumSq / POPULATION_COUNT);
+
+    uint64_t crossoverNs = 0;
+    uint64_t mutationNs = 0;
+    for (auto & c : counters)
+    {
+        record.eliteChildren += c.children[ChildPlan::Elite];
+        record.copiedChildren += c.children[ChildPlan::Copy];
+        record.classicCrossovers += c.children[ChildPlan::Classic];
+        record.linearCrossovers += c.children[ChildPlan::Linear];
+        record.heuristicCrossovers += c.children[ChildPlan::Heuristic];
+        record.fineMutations += c.fineMutations;
+        record.fullMutations += c.fullMutations;
+        crossoverNs += c.crossoverNs;
+        mutationNs += c.mutationNs;
+        c.clear();
+    }
+    record.crossoverSeconds = crossoverNs * 1e-9;
+    record.mutationSeconds = mutationNs * 1e-9;
+    record.selectionSeconds = selectionSeconds;
+    selectionSeconds = 0;
+
+    uint64_t busy = 0;
+    for (auto ns : busyNanoseconds)
+        busy += ns;
+    record.evaluationSeconds = (busy - busyAtLastRecord) * 1e-9;
+    busyAtLastRecord = busy;
+
+    this->telemetry->push(record);
+}
+
+Genocop::StopReason Genocop::checkStop()
+{
+    const auto & stop = runOptions.stop;
+
+    if (stop.cancel != nullptr && stop.cancel->load(std::memory_order_relaxed))
+        stopCause = StopReason::Cancelled;
+    else if (bestScore <= stop.targetValue)
+        stopCause = StopReason::TargetValue;
+    else if (stop.stallGenerations > 0 && iteration - stallIteration >= stop.stallGenerations)
+        stopCause = StopReason::Stalled;
+    else if (stop.minDiversity > 0 && diversity < stop.minDiversity)
+        stopCause = StopReason::Converged;
+    else if (stop.maxEvaluations > 0 && evaluationCount + runOptions.populationCount > stop.maxEvaluations)
+        stopCause = StopReason::EvaluationLimit;
+    else if (stop.maxSeconds > 0 &&
+             std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count() >= stop.maxSeconds)
+        stopCause = StopReason::TimeLimit;
+    else if (iteration >= runOptions.maxIters)
+        stopCause = StopReason::MaxIterations;
+    else
+        stopCause = StopReason::None;
+
+    return stopCause;
+}
+
+void Genocop::notifyCallback()
+{
+    const uint32_t VECTOR_SIZE = this->vectorSize;
+    const uint32_t POPULATION_COUNT = population.rows();
+
+    const bool improved = bestScore < notifiedBest;
+    notifiedBest = bestScore;
+
+    if (this->callback != 0)
+    {
+        // vectors are only allocated on the first call
+        callbackScores.resize(POPULATION_COUNT);
+        for (uint32_t j = 0; j < POPULATION_COUNT; j++)
+        {
+            Vector & x = callbackScores[j].x;
+            if (x.size() != VECTOR_SIZE)
+                x.resize(VECTOR_SIZE);
+
+            const double * row = population.row(j);
+            std::copy(row, row + VECTOR_SIZE, std::begin(x));
+            callbackScores[j].value = scores[j];
+        }
+        callback(callbackScores);
+    }
+
+    PopulationView view;
+    bool viewReady = false;
+    for (const auto & observer : observers)
+    {
+        const Subscription & subscription = observer.subscription;
+        if (!((subscription.every > 0 && iteration % subscription.every == 0) || (subscription.onImprovement && improved)))
+            continue;
+
+        if (!viewReady)
+        {
+            view.genomes = population.view();
+            view.scores = scores.data();
+            view.iteration = iteration;
+            view.bestValue = bestScore;
+            view.bestSolution = &bestSolution[0];
+            view.improved = improved;
+            viewReady = true;
+        }
+        observer.function(view);
+    }
+}
+
+uint32_t Genocop::subscribe(PopulationObserver observer)
+{
+    return subscribe(observer, Subscription());
+}
+
+uint32_t Genocop::subscribe(PopulationObserver observer, const Subscription & subscription)
+{
+    observers.push_back(Observer{nextObserverId, observer, subscription});
+    return nextObserverId++;
+}
+
+void Genocop::unsubscribe(const uint32_t id)
+{
+    observers.erase(std::remove_if(observers.begin(), observers.end(), [id](const Observer & observer)
+    {
+        return observer.id == id;
+    }), observers.end());
+}
+
+void Genocop::calculateScoresCached()
+{
+    const uint32_t VECTOR_SIZE = this->vectorSize;
+    const uint32_t POPULATION_COUNT = population.rows();
+
+    // take known values from the cache, collect the rest
+    missIdx.clear();
+    for (uint32_t j = 0; j < POPULATION_COUNT; j++)
+    {
+        if (!fitnessCache.lookup(population.row(j), scores[j]))
+        {
+            const double * src = population.row(j);
+            std::copy(src, src + VECTOR_SIZE, missRows.row(missIdx.size()));
+            missIdx.push_back(j);
+        }
+    }
+
+    const uint32_t MISS_COUNT = missIdx.size();
+    parallelFor(MISS_COUNT, [this](uint32_t begin, uint32_t end, uint32_t threadIdx)
+    {
+        evaluate(this->missRows.view(begin, end), this->missScores.data() + begin, threadIdx);
+    });
+    evaluationCount += MISS_COUNT;
+
+    // in index order, so that evictions don't depend on the evaluation order
+    for (uint32_t i = 0; i < MISS_COUNT; i++)
+    {
+        scores[missIdx[i]] = missScores[i];
+        fitnessCache.insert(missRows.row(i), missScores[i]);
+    }
+}
+
+void Genocop::evaluate(const PopulationMatrix & rows, double * outScores, const uint32_t threadIdx)
+{
+    const auto evalStart = std::chrono::steady_clock::now();
+    this->objFunction(rows, outScores);
+    busyNanoseconds[threadIdx] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - evalStart).count();
+}
+
+Genocop::Throughput Genocop::throughput() const
+{
+    Throughput result;
+    result.evaluations = evaluationCount;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    if (result.seconds > 0)
+    {
+        result.evaluationsPerSecond = result.evaluations / result.seconds;
+
+        double busy = 0;
+        for (auto ns : busyNanoseconds)
+            busy += ns * 1e-9;
+        result.workerUtilization = busy / (result.seconds * std::max<size_t>(1, busyNanoseconds.size()));
+    }
+    return result;
+}
+
+double Genocop::runSteadyState(Vector & outSolution, Genocop::Options options)
+{
+    // the first population is created and scored as in the generational mode
+    options.cache.capacity = 0;
+    start(options);
+
+    const uint32_t VECTOR_SIZE = this->vectorSize;
+    const uint32_t POPULATION_COUNT = runOptions.populationCount;
+    const uint32_t WORKERS = this->activePool != nullptr ? this->activePool->size() : 1;
+    uint64_t MAX_EVALUATIONS = uint64_t(runOptions.maxIters + 1) * POPULATION_COUNT;
+    if (runOptions.stop.maxEvaluations > 0)
+    {
+        MAX_EVALUATIONS = std::min(MAX_EVALUATIONS, std::max<uint64_t>(evaluationCount, runOptions.stop.maxEvaluations));
+        // enforced exactly by the number of dispatched children
+        runOptions.stop.maxEvaluations = 0;
+    }
+
+    // single parents are selected from an incrementally updated ranking
+    ParentSelector::Settings settings = selectorSettings(runOptions);
+    if (settings.method == ParentSelector::Method::StochasticUniversal)
+    {
+        settings.method = ParentSelector::Method::LinearRanking;
+    }
+    this->selector.prepare(scores, settings);
+
+    double scoreSum = 0;
+    for (auto val : scores)
+        scoreSum += val;
+
+    // one child per worker
+    children.resize(WORKERS, VECTOR_SIZE);
+    std::mutex mutex;
+    uint64_t dispatched = evaluationCount;
+    bool stopped = checkStop() != StopReason::None;
+
+    auto worker = [&](uint32_t begin, uint32_t, uint32_t threadIdx)
+    {
+        double * child = children.row(begin);
+        double * direction = &this->directions[threadIdx][0];
+        double value = 0;
+        uint64_t valueNs = 0;
+        bool hasResult = false;
+
+        while (true)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                if (hasResult)
+                {
+                    // replace the worst individual if the child is better
+                    evaluationCount++;
+                    busyNanoseconds[threadIdx] += valueNs;
+#ifdef GENOCOP_PROFILE
+                    PhaseStats & evaluationStats = profileCounters[threadIdx].phases[uint32_t(ProfilePhase::CalculateScores)];
+                    evaluationStats.calls++;
+                    evaluationStats.nanoseconds += valueNs;
+#endif
+                    const uint32_t worst = this->selector.ranking().back();
+                    if (value < scores[worst])
+                    {
+                        scoreSum += value - scores[worst];
+                        std::copy(child, child + VECTOR_SIZE, population.row(worst));
+                        scores[worst] = value;
+                        this->selector.rerank(scores, worst);
+
+                        if (value < bestScore)
+                        {
+                            bestScore = value;
+                            std::copy(child, child + VECTOR_SIZE, std::begin(bestSolution));
+                        }
+                    }
+
+                    // every populationCount evaluations count as one generation
+                    if (evaluationCount % POPULATION_COUNT == 0)
+                    {
+                        iteration++;
+                        averageScore = scoreSum / POPULATION_COUNT;
+                        updateProgress();
+                        if (this->telemetry != nullptr)
+                            recordGeneration();
+                        collectProfile();
+                        notifyCallback();
+                        stopped = stopped || checkStop() != StopReason::None;
+                    }
+                }
+
+                // cancellation and the time limit are checked for every child, the rest once per generation
+                const auto & stop = runOptions.stop;
+                if (!stopped && ((stop.cancel != nullptr && stop.cancel->load(std::memory_order_relaxed)) ||
+                                 (stop.maxSeconds > 0 && stop.maxSeconds <=
+                                  std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count())))
+                {
+                    stopped = checkStop() != StopReason::None;
+                }
+
+                if (stopped || dispatched >= MAX_EVALUATIONS)
+                    break;
+
+                createSteadyChild(dispatched++, child, direction, threadIdx);
+            }
+
+            // evaluate outside the lock (the time is added to the statistics under the lock)
+            PopulationMatrix row;
+            row.data = child;
+            row.rows = 1;
+            row.cols = VECTOR_SIZE;
+            row.stride = VECTOR_SIZE;
+            const auto evalStart = std::chrono::steady_clock::now();
+            this->objFunction(row, &value);
+            valueNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - evalStart).count();
+            hasResult = true;
+        }
     };
 
-    // finally select parents
-    for (uint32_t i = 0; i < outParents.size(); i++)
+    parallelFor(WORKERS, worker, 1);
+
+    if (stopCause == StopReason::None)
+    {
+        stopCause = iteration >= runOptions.maxIters ? StopReason::MaxIterations : StopReason::EvaluationLimit;
+    }
+
+    outSolution = bestSolution;
+    return bestScore;
+}
+
+void Genocop::createSteadyChild(const uint64_t childNumber, double * outChild, double * direction,
+                                const uint32_t threadIdx)
+{
+    const auto & options = this->runOptions;
+    const uint32_t VECTOR_SIZE = this->vectorSize;
+    Random rng = Random::stream(runSeed, childNumber, STREAM_STEADY);
+
+    ChildPlan childPlan;
+    childPlan.type = ChildPlan::Copy;
+    {
+        GENOCOP_PROFILE_SCOPE(profileCounters[threadIdx], ProfilePhase::SelectParents);
+        childPlan.parent0 = this->selector.selectOne(rng);
+    }
+    childPlan.parent1 = childPlan.parent0;
+
+    if (rng.uniform() <= options.crossover.totalProbability)
+    {
+        // second parent, different from the first if possible
+        GENOCOP_PROFILE_SCOPE(profileCounters[threadIdx], ProfilePhase::SelectParents);
+        for (int i = 0; i < 4 && childPlan.parent1 == childPlan.parent0; i++)
+        {
+            childPlan.parent1 = this->selector.selectOne(rng);
+        }
+
+        const double pClassic = options.crossover.pClassic;
+        const double pLinear = pClassic + options.crossover.pLinear;
+        const double p = rng.uniform();
+        if (p <= pClassic)
+        {
+            childPlan.type = ChildPlan::Classic;
+            childPlan.crossIdx = 1 + rng.index(VECTOR_SIZE - 1);
+        }
+        else if (p <= pLinear)
+        {
+            childPlan.type = ChildPlan::Linear;
+            childPlan.alpha = rng.uniform();
+        }
+        else
+        {
+            childPlan.type = ChildPlan::Heuristic;
+            childPlan.alpha = rng.uniform() * options.crossover.heuristicRangeMult;
+        }
+    }
+
+    // the fine mutation range shrinks with the number of evaluations, as it does over generations
+    const auto & m = options.mutatation;
+    const double progress = std::min(1.0, double(childNumber) / (double(options.maxIters + 1) * options.populationCount));
+    const double fineMutationRange = m.fineMutationMin + (m.fineMutationMax - m.fineMutationMin) * std::pow(1 - progress, 0.8);
+
+    executePlan(population, scores, childPlan, outChild, options, fineMutationRange, rng, direction, threadIdx);
+}
+
+void Genocop::getBest(const uint32_t count, GenomeMatrix & outRows, std::vector<double> & outValues)
+{
+    const uint32_t VECTOR_SIZE = this->vectorSize;
+    const uint32_t N = std::min<uint32_t>(count, population.rows());
+
+    sortScratch.resize(population.rows());
+    for (uint32_t i = 0; i < sortScratch.size(); i++)
+        sortScratch[i] = i;
+
+    std::partial_sort(sortScratch.begin(), sortScratch.begin() + N, sortScratch.end(), [&](uint32_t a, uint32_t b)
+    {
+        return scores[a] < scores[b] || (scores[a] == scores[b] && a < b);
+    });
+
+    outRows.resize(N, VECTOR_SIZE);
+    outValues.resize(N);
+    for (uint32_t i = 0; i < N; i++)
+    {
+        const double * src = population.row(sortScratch[i]);
+        std::copy(src, src + VECTOR_SIZE, outRows.row(i));
+        outValues[i] = scores[sortScratch[i]];
+    }
+}
+
+void Genocop::replaceWorst(const GenomeMatrix & rows, const std::vector<double> & values)
+{
+    const uint32_t VECTOR_SIZE = this->vectorSize;
+    const uint32_t N = std::min<uint32_t>(rows.rows(), population.rows());
+    if (N == 0)
+        return;
+
+    sortScratch.resize(population.rows());
+    for (uint32_t i = 0; i < sortScratch.size(); i++)
+        sortScratch[i] = i;
+
+    // worst first
+    std::nth_element(sortScratch.begin(), sortScratch.begin() + (N - 1), sortScratch.end(), [&](uint32_t a, uint32_t b)
+    {
+        return scores[a] > scores[b] || (scores[a] == scores[b] && a > b);
+    });
+
+    for (uint32_t i = 0; i < N; i++)
+    {
+        const uint32_t dst = sortScratch[i];
+        const double * src = rows.row(i);
+        std::copy(src, src + VECTOR_SIZE, population.row(dst));
+        scores[dst] = values[i];
+
+        if (values[i] < bestScore)
+        {
+            bestScore = values[i];
+            std::copy(src, src + VECTOR_SIZE, std::begin(bestSolution));
+        }
+    }
+}
+
+void Genocop::selectParents(const std::vector<double> & scores, std::vector<uint32_t> & outParents,
+                            const Genocop::Options & options, const uint32_t iter)
+{
+    const ParentSelector::Settings settings = selectorSettings(options);
+    this->selector.prepare(scores, settings);
+
+    if (settings.method == ParentSelector::Method::StochasticUniversal)
     {
-        const uint32_t winnerIdx = runTournament();
-        outParents[i] = scores[winnerIdx];
+        // one spin selects everybody
+        Random rng = getStream(iter, STREAM_SELECT, 0);
+        this->selector.select(outParents, rng);
+        return;
     }
+
+    parallelFor(outParents.size(), [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            Random rng = getStream(iter, STREAM_SELECT, i);
+            outParents[i] = this->selector.selectOne(rng);
+        }
+    });
 }
 
 
-void Genocop::createChildren(const std::vector<Score> & scores, std::vector<Score> & parents,
-                             std::vector<Vector> & outChildren, const Genocop::Options & options,
-                             const uint32_t iter)
+ParentSelector::Settings Genocop::selectorSettings(const Genocop::Options & options)
 {
+    ParentSelector::Settings settings;
+    settings.method = options.selection;
+    settings.tournamentSize = std::max(1, options.tournament.size);
+    settings.tournamentP = options.tournament.p;
+    settings.rankingPressure = options.ranking.pressure;
+    settings.truncationFraction = options.truncation.fraction;
+    return settings;
+}
+
+void Genocop::createChildren(const GenomeMatrix & population, const std::vector<double> & scores,
+                             const std::vector<uint32_t> & parents, GenomeMatrix & outChildren,
+                             const Genocop::Options & options, const uint32_t iter)
+{
+    const uint32_t VECTOR_SIZE = this->vectorSize;
     const uint32_t PARENT_COUNT = parents.size();
-    const uint32_t CHILDREN_COUNT = outChildren.size();
+    const uint32_t CHILDREN_COUNT = outChildren.rows();
+
+    // The plan (which operator, which parents) is made serially from a single stream, 
+    // then children are created and mutated in parallel, each with its own stream
+    Random rng = getStream(iter, STREAM_PLAN, 0);
 
     uint32_t childIdx = 0;
 
     // create children via elitism
     if (options.eliteChildrenCount > 0)
     {
-        auto compareIdx = [&](uint32_t a, uint32_t b)
-        {
-            return scores[a] < scores[b];
-        };
-
-        // find the elite, O(N) time
-        std::nth_element(scoreIdx.begin(), scoreIdx.begin() + options.eliteChildrenCount, scoreIdx.end(), compareIdx);
-        // copy to output
+        // the population was ranked by selectParents
+        const std::vector<uint32_t> & ranking = this->selector.ranking();
         for (uint32_t i = 0; i < options.eliteChildrenCount; i++)
         {
-            outChildren[i] = scores[scoreIdx[i]].x;
+            plan[i].type = ChildPlan::Elite;
+            plan[i].parent0 = ranking[i];
         }
 
         childIdx = options.eliteChildrenCount;
     }
 
-    // children from this position onwards will be affected by mutation
-    const uint32_t mutationStartIdx = childIdx;
-
-    std::uniform_int_distribution<uint32_t> idxRng(0, PARENT_COUNT - 1);
-    auto & rng = this->randomEngine;
-
     // ================================================================
     // ================ Create children via crossovers ================
     // ================================================================
@@ -235,15 +1356,15 @@ void Genocop::createChildren(const std::vector<Score> & scores, std::vector<Scor
 
     for (uint32_t i = 0; i < parents.size() && childIdx < CHILDREN_COUNT; i++)
     {
-        double p = getProbability();
+        double p = rng.uniform();
         if (p > pCrossover)
             continue;
 
         // select parents
-        Score parent0, parent1;
+        uint32_t parent0, parent1;
         {
-            uint32_t idx0 = idxRng(rng);
-            uint32_t idx1 = idxRng(rng);
+            uint32_t idx0 = rng.index(PARENT_COUNT);
+            uint32_t idx1 = rng.index(PARENT_COUNT);
             if (idx1 == idx0)
             {
                 // avoid same parent
@@ -253,30 +1374,36 @@ void Genocop::createChildren(const std::vector<Score> & scores, std::vector<Scor
             parent0 = parents[idx0];
             parent1 = parents[idx1];
         }
-        // allocate children
-        Vector child0 = parent0.x;
-        Vector child1 = parent1.x;
+
+        ChildPlan & child = plan[childIdx++];
+        child.parent0 = parent0;
+        child.parent1 = parent1;
 
         // select type
-        p = getProbability();
+        p = rng.uniform();
         if (p <= pClassic)
         {
-            classicCrossover(parent0, parent1, child0, child1);
-            outChildren[childIdx++] = child0;
+            // [1, vectorSize - 1]
+            child.type = ChildPlan::Classic;
+            child.crossIdx = 1 + rng.index(VECTOR_SIZE - 1);
+
+            // second child with the parents swapped
             if (childIdx < CHILDREN_COUNT)
-                outChildren[childIdx++] = child1;
+            {
+                ChildPlan & sibling = plan[childIdx++];
+                sibling = child;
+                std::swap(sibling.parent0, sibling.parent1);
+            }
         }
         else if (p <= pLinear)
         {
-            const double alpha = getProbability();
-            linearCrossover(parent0, parent1, alpha, child0);
-            outChildren[childIdx++] = child0;
+            child.type = ChildPlan::Linear;
+            child.alpha = rng.uniform();
         }
         else // heuristic
         {
-            const double alpha = getProbability() * options.crossover.heuristicRangeMult;
-            heuristicCrossover(parent0, parent1, alpha, child0);
-            outChildren[childIdx++] = child0;
+            child.type = ChildPlan::Heuristic;
+            child.alpha = rng.uniform() * options.crossover.heuristicRangeMult;
         }        
     }
 
@@ -288,98 +1415,167 @@ void Genocop::createChildren(const std::vector<Score> & scores, std::vector<Scor
     {
         // parents already have duplicates based on function value
         // so it is enough to sample uniformly to give better parents more children
-        uint32_t parentIdx = idxRng(rng);
-        outChildren[childIdx] = parents[parentIdx].x;
+        plan[childIdx].type = ChildPlan::Copy;
+        plan[childIdx].parent0 = parents[rng.index(PARENT_COUNT)];
     }
 
     // ================================================================
-    // =================== Mutate created children ====================
+    // ================= Create and mutate children ===================
     // ================================================================
 
     // determine fine mutation range
     const auto & m = options.mutatation;
     const double fineMutationRange = m.fineMutationMin + (m.fineMutationMax - m.fineMutationMin) * std::pow((1 - double(iter) / options.maxIters), 0.8);
 
-    for (uint32_t i = mutationStartIdx; i < CHILDREN_COUNT; i++)
+    parallelFor(CHILDREN_COUNT, [&](uint32_t begin, uint32_t end, uint32_t threadIdx)
     {
-        double p = getProbability();
-        if (p <= m.pFine)
+        double * direction = &this->directions[threadIdx][0];
+        for (uint32_t i = begin; i < end; i++)
         {
-            fineRangeMutation(outChildren[i], fineMutationRange);
+            Random childRng = getStream(iter, STREAM_CHILD, i);
+            executePlan(population, scores, plan[i], outChildren.row(i), options, fineMutationRange, childRng, direction,
+                        threadIdx);
         }
-
-        p = getProbability();
-        if (p <= m.pFull)
-        {
-            fullRangeMutation(outChildren[i], m.pFull); 
-        }            
-    }
+    });
 }
 
-void Genocop::classicCrossover(const Score & parent0, const Score & parent1,
-                               Vector & outChild0, Vector & outChild1)
+void Genocop::executePlan(const GenomeMatrix & population, const std::vector<double> & scores,
+                          const ChildPlan & childPlan, double * outChild,
+                          const Genocop::Options & options, const double fineMutationRange,
+                          Random & rng, double * direction, const uint32_t threadIdx)
 {
     const uint32_t VECTOR_SIZE = this->vectorSize;
-    const uint32_t crossIdx = getCrossoverIdx();
+    const double * parent0 = population.row(childPlan.parent0);
+    const double * parent1 = population.row(childPlan.parent1);
 
-    uint32_t i = 0;
-    for (; i < crossIdx; i++)
+    OperatorCounters * counters = this->telemetry != nullptr ? &this->counters[threadIdx] : nullptr;
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point crossoverStart;
+    if (counters != nullptr)
     {
-        outChild0[i] = parent0.x[i];
-        outChild1[i] = parent1.x[i];
+        counters->children[childPlan.type]++;
+        crossoverStart = Clock::now();
     }
-    for (; i < VECTOR_SIZE; i++)
+
+    switch (childPlan.type)
+    {
+    case ChildPlan::Elite:
+        std::copy(parent0, parent0 + VECTOR_SIZE, outChild);
+        // elite children are not mutated
+        return;
+    case ChildPlan::Copy:
+        std::copy(parent0, parent0 + VECTOR_SIZE, outChild);
+        break;
+    case ChildPlan::Classic:
+    {
+        GENOCOP_PROFILE_SCOPE(profileCounters[threadIdx], ProfilePhase::ClassicCrossover);
+        classicCrossover(parent0, parent1, childPlan.crossIdx, outChild);
+        break;
+    }
+    case ChildPlan::Linear:
     {
-        outChild0[i] = parent1.x[i];
-        outChild1[i] = parent0.x[i];
+        GENOCOP_PROFILE_SCOPE(profileCounters[threadIdx], ProfilePhase::LinearCrossover);
+        linearCrossover(parent0, parent1, childPlan.alpha, outChild);
+        break;
+    }
+    case ChildPlan::Heuristic:
+    {
+        GENOCOP_PROFILE_SCOPE(profileCounters[threadIdx], ProfilePhase::HeuristicCrossover);
+        heuristicCrossover(parent0, scores[childPlan.parent0], parent1, scores[childPlan.parent1], 
+                           childPlan.alpha, outChild);
+        break;
+    }
     }
+
+    Clock::time_point mutationStart;
+    if (counters != nullptr)
+    {
+        mutationStart = Clock::now();
+        counters->crossoverNs += std::chrono::duration_cast<std::chrono::nanoseconds>(mutationStart - crossoverStart).count();
+    }
+
+    // mutation
+    const auto & m = options.mutatation;
+
+    double p = rng.uniform();
+    const bool fine = p <= m.pFine;
+    if (fine)
+    {
+        GENOCOP_PROFILE_SCOPE(profileCounters[threadIdx], ProfilePhase::FineMutation);
+        fineRangeMutation(outChild, fineMutationRange, rng, direction);
+    }
+
+    p = rng.uniform();
+    const bool full = p <= m.pFull;
+    if (full)
+    {
+        GENOCOP_PROFILE_SCOPE(profileCounters[threadIdx], ProfilePhase::FullMutation);
+        fullRangeMutation(outChild, rng); 
+    }
+
+    if (!constraints.empty())
+    {
+        // a fully mutated child has nothing left of its parent: a random point towards it from the interior point
+        if (full)
+            repair(outChild, constraints.interiorPoint(), true, rng);
+        else
+            repair(outChild, parent0, false, rng);
+    }
+
+    if (counters != nullptr)
+    {
+        counters->fineMutations += fine;
+        counters->fullMutations += full;
+        counters->mutationNs += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - mutationStart).count();
+    }
+}
+
+void Genocop::classicCrossover(const double * parent0, const double * parent1, const uint32_t crossIdx,
+                               double * outChild)
+{
+    const uint32_t VECTOR_SIZE = this->vectorSize;
+
+    std::copy(parent0, parent0 + crossIdx, outChild);
+    std::copy(parent1 + crossIdx, parent1 + VECTOR_SIZE, outChild + crossIdx);
 }
 
-void Genocop::linearCrossover(const Score & parent0, const Score & parent1, double alpha,
-                              Vector & outChild)
+void Genocop::linearCrossover(const double * parent0, const double * parent1, double alpha,
+                              double * outChild)
 {
-    outChild = (1.0 - alpha) * parent0.x + alpha * parent1.x;
+    this->kernels.blend(parent0, parent1, alpha, outChild, this->vectorSize);
 }
 
-void Genocop::heuristicCrossover(const Score & parent0, const Score & parent1, double alpha,
-                                 Vector & outChild)
+void Genocop::heuristicCrossover(const double * parent0, const double value0,
+                                 const double * parent1, const double value1,
+                                 double alpha, double * outChild)
 {
-    if (parent0.value > parent1.value)
+    if (value0 > value1)
     {
-        outChild = (1.0 - alpha) * parent0.x + alpha * parent1.x;
+        linearCrossover(parent0, parent1, alpha, outChild);
     }
     else
     {
-        outChild = (1.0 - alpha) * parent1.x + alpha * parent0.x;
+        linearCrossover(parent1, parent0, alpha, outChild);
     }
 }
 
-void Genocop::fullRangeMutation(Vector & x, const double pFull)
+void Genocop::fullRangeMutation(double * x, Random & rng)
 {
-    for (uint32_t i = 0; i < x.size(); i++)
-    {
-        // full range mutation: set element to random value in range
-        const double normalizedValue = getMutation();
-        x[i] = offsetX[i] + scaleX[i] * normalizedValue;
-    }
+    // full range mutation: set each element to a random value in range
+    rng.fillUniform(x, this->vectorSize, -1.0, 1.0);
+    this->kernels.affine(&offsetX[0], &scaleX[0], x, x, this->vectorSize);
 }
 
-void Genocop::fineRangeMutation(Vector & x, const double range)
+void Genocop::fineRangeMutation(double * x, const double range, Random & rng, double * direction)
 {
-    Vector dir = x;
-    getRandomDirection(dir);
-    double mult = getMutation() * range;
-    dir *= mult;
+    getRandomDirection(direction, rng);
+    const double mult = rng.uniform(-1.0, 1.0) * range;
 
-    x += dir;
-    for (uint32_t i = 0; i < x.size(); i++)
-    {
-        x[i] = std::max(x[i], this->xMin[i]);
-        x[i] = std::min(x[i], this->xMax[i]);
-    }
+    this->kernels.stepClamp(x, direction, mult, &this->xMin[0], &this->xMax[0], this->vectorSize);
 }
 
-inline void Genocop::getRandomDirection(Vector & dir)
+void Genocop::getRandomDirection(double * dir, Random & rng)
 {
     // Generate random direction in N-space as per Muller, M. E. "A Note on a Method for Generating Points Uniformly on N-Dimensional Spheres.", 1959. 
 
@@ -388,15 +1584,11 @@ inline void Genocop::getRandomDirection(Vector & dir)
     while (sumSq < 1e-5 && i < 3) // avoid too small sums
     {
         i++;
-        for (uint32_t i = 0; i < dir.size(); i++)
-        {
-            double val = this->dRng(this->randomEngine);
-            sumSq += val * val;
-            dir[i] = val;
-        }
+        rng.fillNormal(dir, this->vectorSize);
+        sumSq = this->kernels.sumSquares(dir, this->vectorSize);
     }
 
     sumSq = std::max(1e-5, sumSq); // we may have been very unlucky
     const double mult = 1.0 / std::sqrt(sumSq);
-    dir *= mult;
-}
\ No newline at end of file
+    this->kernels.scale(dir, mult, this->vectorSize);
+}
@@ -0,0 +1,35 @@
+#include "GenomeMatrix.h"
+
+#include <utility>
+
+void GenomeMatrix::resize(const uint32_t rows, const uint32_t cols)
+{
+    // round each row up to a whole number of cache lines
+    const uint32_t stride = (cols + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    const size_t required = size_t(rows) * stride;
+
+    if (required > capacity)
+    {
+        // over-allocate by one cache line so that the start can be aligned
+        storage.reset(new double[required + ALIGNMENT]);
+        const uintptr_t address = reinterpret_cast<uintptr_t>(storage.get());
+        const uintptr_t alignBytes = ALIGNMENT * sizeof(double);
+        const uintptr_t aligned = (address + alignBytes - 1) / alignBytes * alignBytes;
+        data = reinterpret_cast<double *>(aligned);
+        capacity = required;
+    }
+
+    rowCount = rows;
+    colCount = cols;
+    rowStride = stride;
+}
+
+void GenomeMatrix::swap(GenomeMatrix & other)
+{
+    std::swap(storage, other.storage);
+    std::swap(capacity, other.capacity);
+    std::swap(data, other.data);
+    std::swap(rowCount, other.rowCount);
+    std::swap(colCount, other.colCount);
+    std::swap(rowStride, other.rowStride);
+}
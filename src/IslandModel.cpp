@@ -0,0 +1,216 @@
+#include "IslandModel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+IslandModel::IslandModel(const uint32_t vectorSize, ObjectiveFunction objective,
+                         const Vector xMin, const Vector xMax) :
+                            IslandModel(vectorSize, makeBatchObjective(objective), xMin, xMax)
+{
+}
+
+IslandModel::IslandModel(const uint32_t vectorSize, BatchObjectiveFunction objective,
+                         const Vector xMin, const Vector xMax) :
+                            vectorSize(vectorSize), objective(objective), xMin(xMin), xMax(xMax)
+{
+}
+
+double IslandModel::run(Vector & outSolution, const IslandModel::Options & options)
+{
+    const uint32_t ISLAND_COUNT = options.islandCount;
+    const uint32_t MAX_ITERS = options.island.maxIters;
+    if (ISLAND_COUNT == 0)
+    {
+        throw std::runtime_error("No islands!");
+    }
+
+    uint64_t seed = options.island.seed;
+    if (seed == 0)
+    {
+        seed = std::chrono::system_clock::now().time_since_epoch().count();
+    }
+
+    // one thread per island by default
+    uint32_t threadCount = options.threadCount;
+    if (threadCount == 0)
+    {
+        threadCount = std::min(ISLAND_COUNT, std::max(1u, std::thread::hardware_concurrency()));
+    }
+    if (!threadPool || threadPool->size() != threadCount)
+    {
+        threadPool.reset(new ThreadPool(threadCount));
+    }
+
+    if (islands.size() != ISLAND_COUNT)
+    {
+        islands.clear();
+        for (uint32_t i = 0; i < ISLAND_COUNT; i++)
+        {
+            islands.emplace_back(new Genocop(vectorSize, objective, xMin, xMax));
+        }
+    }
+    migrants.resize(ISLAND_COUNT);
+    migrantValues.resize(ISLAND_COUNT);
+    targets.resize(ISLAND_COUNT);
+
+    // the evaluation budget is shared between the islands, so that their memetic stages stay within it
+    const auto & stop = options.island.stop;
+    const uint64_t islandEvaluations = stop.maxEvaluations > 0 ? std::max<uint64_t>(1, stop.maxEvaluations / ISLAND_COUNT) : 0;
+
+    // each island gets its own seed derived from the model seed
+    threadPool->parallelFor(ISLAND_COUNT, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            Genocop::Options islandOptions = options.island;
+            islandOptions.threadCount = 1;
+            islandOptions.seed = std::max<uint64_t>(1, Random::stream(seed, i, 0)());
+            islandOptions.stop.maxEvaluations = islandEvaluations;
+            islands[i]->start(islandOptions);
+        }
+    }, 1);
+
+    const auto runStart = std::chrono::steady_clock::now();
+    auto timeIsUp = [&]()
+    {
+        return stop.maxSeconds > 0 &&
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count() >= stop.maxSeconds;
+    };
+
+    // evolve in epochs of migrationInterval generations until maxIters or a stopping criterion of options.island.stop,
+    // checked on the whole model after each epoch. Cancel and the time limit are also checked between generations
+    const uint32_t interval = std::max(1u, options.migrationInterval);
+    const uint64_t generationEvaluations = uint64_t(ISLAND_COUNT) * options.island.populationCount;
+    uint32_t iteration = 0;
+    uint32_t epoch = 0;
+    double stallBest = 1e+99;
+    uint32_t stallIteration = 0;
+    stopCause = Genocop::StopReason::None;
+    while (stopCause == Genocop::StopReason::None)
+    {
+        double best = islands[0]->bestValue();
+        uint64_t evaluations = 0;
+        double diversity = 0;
+        for (uint32_t i = 0; i < ISLAND_COUNT; i++)
+        {
+            best = std::min(best, islands[i]->bestValue());
+            evaluations += islands[i]->evaluations();
+            diversity = std::max(diversity, islands[i]->populationDiversity());
+        }
+        if (best < stallBest - stop.stallTolerance)
+        {
+            stallBest = best;
+            stallIteration = iteration;
+        }
+
+        // generations of the epoch that fit in the evaluation budget
+        uint32_t steps = std::min(interval, MAX_ITERS - iteration);
+        if (stop.maxEvaluations > 0)
+        {
+            const uint64_t left = evaluations < stop.maxEvaluations ? stop.maxEvaluations - evaluations : 0;
+            steps = uint32_t(std::min<uint64_t>(steps, left / generationEvaluations));
+        }
+
+        if (stop.cancel != nullptr && stop.cancel->load(std::memory_order_relaxed))
+            stopCause = Genocop::StopReason::Cancelled;
+        else if (best <= stop.targetValue)
+            stopCause = Genocop::StopReason::TargetValue;
+        else if (stop.stallGenerations > 0 && iteration - stallIteration >= stop.stallGenerations)
+            stopCause = Genocop::StopReason::Stalled;
+        else if (stop.minDiversity > 0 && diversity < stop.minDiversity)
+            stopCause = Genocop::StopReason::Converged;
+        else if (iteration < MAX_ITERS && steps == 0)
+            stopCause = Genocop::StopReason::EvaluationLimit;
+        else if (timeIsUp())
+            stopCause = Genocop::StopReason::TimeLimit;
+        else if (iteration >= MAX_ITERS)
+            stopCause = Genocop::StopReason::MaxIterations;
+        if (stopCause != Genocop::StopReason::None)
+            break;
+
+        std::atomic<bool> interrupted(false);
+        threadPool->parallelFor(ISLAND_COUNT, [&](uint32_t begin, uint32_t end, uint32_t)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                for (uint32_t j = 0; j < steps; j++)
+                {
+                    if ((stop.cancel != nullptr && stop.cancel->load(std::memory_order_relaxed)) || timeIsUp())
+                    {
+                        interrupted = true;
+                        break;
+                    }
+                    islands[i]->step();
+                }
+            }
+        }, 1);
+        if (interrupted)
+        {
+            // the islands are at different generations: no migration, the next check sets the reason
+            continue;
+        }
+        iteration += steps;
+
+        if (iteration < MAX_ITERS && ISLAND_COUNT > 1 && options.migrantCount > 0)
+        {
+            migrate(options, seed, epoch);
+        }
+        epoch++;
+
+        if (callback != 0)
+        {
+            double best = islands[0]->bestValue();
+            for (uint32_t i = 1; i < ISLAND_COUNT; i++)
+                best = std::min(best, islands[i]->bestValue());
+            callback(iteration, best);
+        }
+    }
+
+    // global best - first island wins ties
+    uint32_t bestIsland = 0;
+    for (uint32_t i = 1; i < ISLAND_COUNT; i++)
+    {
+        if (islands[i]->bestValue() < islands[bestIsland]->bestValue())
+            bestIsland = i;
+    }
+
+    outSolution = islands[bestIsland]->bestVector();
+    return islands[bestIsland]->bestValue();
+}
+
+void IslandModel::migrate(const IslandModel::Options & options, const uint64_t seed, const uint32_t epoch)
+{
+    const uint32_t ISLAND_COUNT = islands.size();
+
+    if (options.topology == Topology::Ring)
+    {
+        for (uint32_t i = 0; i < ISLAND_COUNT; i++)
+            targets[i] = (i + 1) % ISLAND_COUNT;
+    }
+    else
+    {
+        // random ring: shuffle the islands and send to the next one in the shuffled order.
+        // Every island sends and receives exactly once and never to itself
+        Random rng = Random::stream(seed, epoch, 1ull << 32);
+        std::vector<uint32_t> order(ISLAND_COUNT);
+        for (uint32_t i = 0; i < ISLAND_COUNT; i++)
+            order[i] = i;
+        for (uint32_t i = ISLAND_COUNT - 1; i > 0; i--)
+            std::swap(order[i], order[rng.index(i + 1)]);
+
+        for (uint32_t i = 0; i < ISLAND_COUNT; i++)
+            targets[order[i]] = order[(i + 1) % ISLAND_COUNT];
+    }
+
+    // take all migrants first so that an island doesn't send individuals it just received
+    for (uint32_t i = 0; i < ISLAND_COUNT; i++)
+    {
+        islands[i]->getBest(options.migrantCount, migrants[i], migrantValues[i]);
+    }
+
+    for (uint32_t i = 0; i < ISLAND_COUNT; i++)
+    {
+        islands[targets[i]]->replaceWorst(migrants[i], migrantValues[i]);
+    }
+}
@@ -0,0 +1,320 @@
+#include "Kernels.h"
+
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KERNELS_X86
+#include <immintrin.h>
+#endif
+
+// Sums of squares are accumulated in SUM_LANES partial sums (element i goes to lane i % SUM_LANES)
+// which are added in order at the end, so every implementation gives the same result
+static const uint32_t SUM_LANES = 8;
+
+static double reduceLanes(const double * lanes)
+{
+    double sum = 0;
+    for (uint32_t i = 0; i < SUM_LANES; i++)
+    {
+        sum += lanes[i];
+    }
+    return sum;
+}
+
+// =============================================
+// =================== Scalar ==================
+// =============================================
+
+static void blendScalar(const double * a, const double * b, const double alpha, double * out, const uint32_t n)
+{
+    const double beta = 1.0 - alpha;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        out[i] = beta * a[i] + alpha * b[i];
+    }
+}
+
+static void stepClampScalar(double * x, const double * dir, const double mult,
+                            const double * lo, const double * hi, const uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        const double val = x[i] + mult * dir[i];
+        x[i] = std::min(std::max(val, lo[i]), hi[i]);
+    }
+}
+
+static void affineScalar(const double * offset, const double * scale, const double * u, double * out, const uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        out[i] = offset[i] + scale[i] * u[i];
+    }
+}
+
+static void scaleScalar(double * x, const double mult, const uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        x[i] *= mult;
+    }
+}
+
+static double sumSquaresScalar(const double * x, const uint32_t n)
+{
+    double lanes[SUM_LANES] = {0};
+    for (uint32_t i = 0; i < n; i++)
+    {
+        lanes[i % SUM_LANES] += x[i] * x[i];
+    }
+    return reduceLanes(lanes);
+}
+
+#ifdef KERNELS_X86
+
+// =============================================
+// ==================== AVX2 ===================
+// =============================================
+
+__attribute__((target("avx2")))
+static void blendAvx2(const double * a, const double * b, const double alpha, double * out, const uint32_t n)
+{
+    const double beta = 1.0 - alpha;
+    const __m256d vAlpha = _mm256_set1_pd(alpha);
+    const __m256d vBeta = _mm256_set1_pd(beta);
+
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m256d va = _mm256_loadu_pd(a + i);
+        const __m256d vb = _mm256_loadu_pd(b + i);
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(vBeta, va), _mm256_mul_pd(vAlpha, vb)));
+    }
+    for (; i < n; i++)
+    {
+        out[i] = beta * a[i] + alpha * b[i];
+    }
+}
+
+__attribute__((target("avx2")))
+static void stepClampAvx2(double * x, const double * dir, const double mult,
+                          const double * lo, const double * hi, const uint32_t n)
+{
+    const __m256d vMult = _mm256_set1_pd(mult);
+
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d val = _mm256_add_pd(_mm256_loadu_pd(x + i), _mm256_mul_pd(vMult, _mm256_loadu_pd(dir + i)));
+        val = _mm256_max_pd(val, _mm256_loadu_pd(lo + i));
+        val = _mm256_min_pd(val, _mm256_loadu_pd(hi + i));
+        _mm256_storeu_pd(x + i, val);
+    }
+    for (; i < n; i++)
+    {
+        const double val = x[i] + mult * dir[i];
+        x[i] = std::min(std::max(val, lo[i]), hi[i]);
+    }
+}
+
+__attribute__((target("avx2")))
+static void affineAvx2(const double * offset, const double * scale, const double * u, double * out, const uint32_t n)
+{
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m256d val = _mm256_mul_pd(_mm256_loadu_pd(scale + i), _mm256_loadu_pd(u + i));
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(offset + i), val));
+    }
+    for (; i < n; i++)
+    {
+        out[i] = offset[i] + scale[i] * u[i];
+    }
+}
+
+__attribute__((target("avx2")))
+static void scaleAvx2(double * x, const double mult, const uint32_t n)
+{
+    const __m256d vMult = _mm256_set1_pd(mult);
+
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm256_storeu_pd(x + i, _mm256_mul_pd(_mm256_loadu_pd(x + i), vMult));
+    }
+    for (; i < n; i++)
+    {
+        x[i] *= mult;
+    }
+}
+
+__attribute__((target("avx2")))
+static double sumSquaresAvx2(const double * x, const uint32_t n)
+{
+    // two registers = lanes 0..3 and 4..7
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+
+    uint32_t i = 0;
+    for (; i + SUM_LANES <= n; i += SUM_LANES)
+    {
+        const __m256d v0 = _mm256_loadu_pd(x + i);
+        const __m256d v1 = _mm256_loadu_pd(x + i + 4);
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(v0, v0));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(v1, v1));
+    }
+
+    double lanes[SUM_LANES];
+    _mm256_storeu_pd(lanes, acc0);
+    _mm256_storeu_pd(lanes + 4, acc1);
+    for (; i < n; i++)
+    {
+        lanes[i % SUM_LANES] += x[i] * x[i];
+    }
+    return reduceLanes(lanes);
+}
+
+// =============================================
+// ================== AVX-512 ==================
+// =============================================
+
+__attribute__((target("avx512f")))
+static void blendAvx512(const double * a, const double * b, const double alpha, double * out, const uint32_t n)
+{
+    const double beta = 1.0 - alpha;
+    const __m512d vAlpha = _mm512_set1_pd(alpha);
+    const __m512d vBeta = _mm512_set1_pd(beta);
+
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m512d va = _mm512_loadu_pd(a + i);
+        const __m512d vb = _mm512_loadu_pd(b + i);
+        _mm512_storeu_pd(out + i, _mm512_add_pd(_mm512_mul_pd(vBeta, va), _mm512_mul_pd(vAlpha, vb)));
+    }
+    for (; i < n; i++)
+    {
+        out[i] = beta * a[i] + alpha * b[i];
+    }
+}
+
+__attribute__((target("avx512f")))
+static void stepClampAvx512(double * x, const double * dir, const double mult,
+                            const double * lo, const double * hi, const uint32_t n)
+{
+    const __m512d vMult = _mm512_set1_pd(mult);
+
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512d val = _mm512_add_pd(_mm512_loadu_pd(x + i), _mm512_mul_pd(vMult, _mm512_loadu_pd(dir + i)));
+        val = _mm512_mask_max_pd(val, 0xFF, val, _mm512_loadu_pd(lo + i));
+        val = _mm512_mask_min_pd(val, 0xFF, val, _mm512_loadu_pd(hi + i));
+        _mm512_storeu_pd(x + i, val);
+    }
+    for (; i < n; i++)
+    {
+        const double val = x[i] + mult * dir[i];
+        x[i] = std::min(std::max(val, lo[i]), hi[i]);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void affineAvx512(const double * offset, const double * scale, const double * u, double * out, const uint32_t n)
+{
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m512d val = _mm512_mul_pd(_mm512_loadu_pd(scale + i), _mm512_loadu_pd(u + i));
+        _mm512_storeu_pd(out + i, _mm512_add_pd(_mm512_loadu_pd(offset + i), val));
+    }
+    for (; i < n; i++)
+    {
+        out[i] = offset[i] + scale[i] * u[i];
+    }
+}
+
+__attribute__((target("avx512f")))
+static void scaleAvx512(double * x, const double mult, const uint32_t n)
+{
+    const __m512d vMult = _mm512_set1_pd(mult);
+
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm512_storeu_pd(x + i, _mm512_mul_pd(_mm512_loadu_pd(x + i), vMult));
+    }
+    for (; i < n; i++)
+    {
+        x[i] *= mult;
+    }
+}
+
+__attribute__((target("avx512f")))
+static double sumSquaresAvx512(const double * x, const uint32_t n)
+{
+    __m512d acc = _mm512_setzero_pd();
+
+    uint32_t i = 0;
+    for (; i + SUM_LANES <= n; i += SUM_LANES)
+    {
+        const __m512d v = _mm512_loadu_pd(x + i);
+        acc = _mm512_add_pd(acc, _mm512_mul_pd(v, v));
+    }
+
+    double lanes[SUM_LANES];
+    _mm512_storeu_pd(lanes, acc);
+    for (; i < n; i++)
+    {
+        lanes[i % SUM_LANES] += x[i] * x[i];
+    }
+    return reduceLanes(lanes);
+}
+
+#endif // KERNELS_X86
+
+// =============================================
+// ================== Dispatch =================
+// =============================================
+
+static Kernels selectKernels()
+{
+    Kernels k;
+    k.blend = blendScalar;
+    k.stepClamp = stepClampScalar;
+    k.affine = affineScalar;
+    k.scale = scaleScalar;
+    k.sumSquares = sumSquaresScalar;
+    k.name = "scalar";
+
+#ifdef KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        k.blend = blendAvx512;
+        k.stepClamp = stepClampAvx512;
+        k.affine = affineAvx512;
+        k.scale = scaleAvx512;
+        k.sumSquares = sumSquaresAvx512;
+        k.name = "avx512";
+    }
+    else if (__builtin_cpu_supports("avx2"))
+    {
+        k.blend = blendAvx2;
+        k.stepClamp = stepClampAvx2;
+        k.affine = affineAvx2;
+        k.scale = scaleAvx2;
+        k.sumSquares = sumSquaresAvx2;
+        k.name = "avx2";
+    }
+#endif
+
+    return k;
+}
+
+const Kernels & Kernels::get()
+{
+    // thread safe initialization (C++11 magic statics)
+    static const Kernels kernels = selectKernels();
+    return kernels;
+}
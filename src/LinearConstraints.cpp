@@ -0,0 +1,297 @@
+#include "LinearConstraints.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "Random.h"
+
+// feasibility is checked up to this fraction of the magnitude of the terms of a constraint: a few thousand ulps,
+// so the objective never sees a point that is infeasible by more than rounding
+static const double RELATIVE_TOLERANCE = 1e-12;
+// dependent equalities reduced by the elimination must vanish up to this fraction (rounding accumulates over the rows)
+static const double DEPENDENT_TOLERANCE = 1e-9;
+
+// starting points of the search for feasible points (box center + random ones)
+static const uint32_t FEASIBLE_STARTS = 16;
+static const uint32_t MAX_PROJECTION_SWEEPS = 2000;
+
+static double dot(const double * a, const double * x, const uint32_t n)
+{
+    double sum = 0;
+    for (uint32_t k = 0; k < n; k++)
+        sum += a[k] * x[k];
+    return sum;
+}
+
+LinearConstraints::LinearConstraints(const uint32_t vectorSize) : n(vectorSize)
+{
+}
+
+void LinearConstraints::addEquality(const Vector & a, const double b)
+{
+    if (a.size() != n)
+    {
+        throw std::runtime_error("Constraint of a different vector size!");
+    }
+    equalityA.insert(equalityA.end(), std::begin(a), std::end(a));
+    equalityB.push_back(b);
+}
+
+void LinearConstraints::addInequality(const Vector & a, const double b)
+{
+    if (a.size() != n)
+    {
+        throw std::runtime_error("Constraint of a different vector size!");
+    }
+    inequalityA.insert(inequalityA.end(), std::begin(a), std::end(a));
+    inequalityB.push_back(b);
+}
+
+void LinearConstraints::prepare(const Vector & xMin, const Vector & xMax)
+{
+    eliminateEqualities(xMin, xMax);
+    boxMin.resize(n);
+    boxMin = xMin;
+    boxMax.resize(n);
+    boxMax = xMax;
+
+    // =============================================
+    // ================ Checked rows ===============
+    // =============================================
+
+    rowA = inequalityA;
+    rowB = inequalityB;
+    for (auto p : pivots)
+    {
+        // x[p] <= xMax[p] and -x[p] <= -xMin[p]
+        rowA.resize(rowA.size() + 2 * n, 0.0);
+        rowA[rowA.size() - 2 * n + p] = 1;
+        rowA[rowA.size() - n + p] = -1;
+        rowB.push_back(xMax[p]);
+        rowB.push_back(-xMin[p]);
+    }
+
+    const uint32_t rowCount = rowB.size();
+    rowTolerance.resize(rowCount);
+    for (uint32_t r = 0; r < rowCount; r++)
+    {
+        double magnitude = std::abs(rowB[r]);
+        for (uint32_t k = 0; k < n; k++)
+            magnitude += std::abs(rowA[size_t(r) * n + k]) * std::max(std::abs(xMin[k]), std::abs(xMax[k]));
+        rowTolerance[r] = RELATIVE_TOLERANCE * magnitude + 1e-300;
+    }
+
+    // =============================================
+    // =============== Interior point ==============
+    // =============================================
+
+    interior.resize(n);
+    interior = 0.0;
+    uint32_t found = 0;
+    Vector x(n);
+    Random rng(FEASIBLE_STARTS);
+    for (uint32_t s = 0; s < FEASIBLE_STARTS; s++)
+    {
+        for (uint32_t k = 0; k < n; k++)
+            x[k] = s == 0 ? 0.5 * (xMin[k] + xMax[k]) : rng.uniform(xMin[k], xMax[k]);
+
+        if (findFeasible(&x[0], xMin, xMax))
+        {
+            interior += x;
+            found++;
+        }
+    }
+
+    if (found == 0)
+    {
+        throw std::runtime_error("No feasible point found - the constraints may be infeasible!");
+    }
+    interior /= double(found);
+    complete(&interior[0]);
+}
+
+void LinearConstraints::eliminateEqualities(const Vector & xMin, const Vector & xMax)
+{
+    const uint32_t m = equalityB.size();
+    std::vector<double> a = equalityA;
+    std::vector<double> b = equalityB;
+
+    double maxCoefficient = 0;
+    for (auto value : a)
+        maxCoefficient = std::max(maxCoefficient, std::abs(value));
+    const double zero = 1e-12 * maxCoefficient;
+
+    // Gauss-Jordan elimination with full pivoting
+    pivots.clear();
+    std::vector<bool> isPivot(n, false);
+    uint32_t rank = 0;
+    for (; rank < m; rank++)
+    {
+        uint32_t bestRow = rank;
+        uint32_t bestColumn = n;
+        double bestValue = zero;
+        for (uint32_t i = rank; i < m; i++)
+        {
+            for (uint32_t k = 0; k < n; k++)
+            {
+                if (!isPivot[k] && std::abs(a[size_t(i) * n + k]) > bestValue)
+                {
+                    bestValue = std::abs(a[size_t(i) * n + k]);
+                    bestRow = i;
+                    bestColumn = k;
+                }
+            }
+        }
+        if (bestColumn == n)
+            break; // the remaining rows are zero
+
+        std::swap_ranges(&a[size_t(rank) * n], &a[size_t(rank) * n] + n, &a[size_t(bestRow) * n]);
+        std::swap(b[rank], b[bestRow]);
+
+        double * pivotRow = &a[size_t(rank) * n];
+        const double scale = 1.0 / pivotRow[bestColumn];
+        for (uint32_t k = 0; k < n; k++)
+            pivotRow[k] *= scale;
+        b[rank] *= scale;
+
+        for (uint32_t i = 0; i < m; i++)
+        {
+            const double factor = a[size_t(i) * n + bestColumn];
+            if (i == rank || factor == 0)
+                continue;
+            double * row = &a[size_t(i) * n];
+            for (uint32_t k = 0; k < n; k++)
+                row[k] -= factor * pivotRow[k];
+            b[i] -= factor * b[rank];
+        }
+
+        isPivot[bestColumn] = true;
+        pivots.push_back(bestColumn);
+    }
+
+    // dependent rows must be 0 = 0
+    double scaleB = 0;
+    for (uint32_t k = 0; k < n; k++)
+        scaleB += maxCoefficient * std::max(std::abs(xMin[k]), std::abs(xMax[k]));
+    for (uint32_t i = rank; i < m; i++)
+    {
+        if (std::abs(b[i]) > DEPENDENT_TOLERANCE * scaleB + 1e-300)
+        {
+            throw std::runtime_error("Inconsistent equality constraints!");
+        }
+    }
+
+    freeIdx.clear();
+    for (uint32_t k = 0; k < n; k++)
+    {
+        if (!isPivot[k])
+            freeIdx.push_back(k);
+    }
+
+    const uint32_t freeCount = freeIdx.size();
+    pivotCoefficients.resize(size_t(rank) * freeCount);
+    pivotConstants.assign(b.begin(), b.begin() + rank);
+    for (uint32_t i = 0; i < rank; i++)
+    {
+        for (uint32_t k = 0; k < freeCount; k++)
+            pivotCoefficients[size_t(i) * freeCount + k] = a[size_t(i) * n + freeIdx[k]];
+    }
+}
+
+void LinearConstraints::complete(double * x) const
+{
+    const uint32_t freeCount = freeIdx.size();
+    for (uint32_t i = 0; i < pivots.size(); i++)
+    {
+        const double * coefficients = &pivotCoefficients[size_t(i) * freeCount];
+        double value = pivotConstants[i];
+        for (uint32_t k = 0; k < freeCount; k++)
+            value -= coefficients[k] * x[freeIdx[k]];
+        x[pivots[i]] = value;
+    }
+}
+
+bool LinearConstraints::feasible(const double * x) const
+{
+    // the box of the free variables is exact, the pivots are computed and get the rounding tolerance
+    for (auto k : freeIdx)
+    {
+        if (x[k] < boxMin[k] || x[k] > boxMax[k])
+            return false;
+    }
+    for (uint32_t r = 0; r < rowB.size(); r++)
+    {
+        if (dot(&rowA[size_t(r) * n], x, n) > rowB[r] + rowTolerance[r])
+            return false;
+    }
+    return true;
+}
+
+double LinearConstraints::maxStep(const double * from, const double * to) const
+{
+    double t = 1;
+    for (auto k : freeIdx)
+    {
+        if (to[k] > boxMax[k])
+            t = std::min(t, std::max(0.0, boxMax[k] - from[k]) / (to[k] - from[k]));
+        else if (to[k] < boxMin[k])
+            t = std::min(t, std::max(0.0, from[k] - boxMin[k]) / (from[k] - to[k]));
+    }
+    for (uint32_t r = 0; r < rowB.size(); r++)
+    {
+        const double * a = &rowA[size_t(r) * n];
+        const double atTo = dot(a, to, n);
+        if (atTo <= rowB[r] + rowTolerance[r])
+            continue;
+
+        // the row is crossed between from (inside) and to (outside)
+        const double atFrom = dot(a, from, n);
+        t = std::min(t, std::max(0.0, rowB[r] - atFrom) / (atTo - atFrom));
+    }
+    return t;
+}
+
+void LinearConstraints::clampToBox(double * x) const
+{
+    for (uint32_t k = 0; k < n; k++)
+        x[k] = std::min(std::max(x[k], boxMin[k]), boxMax[k]);
+}
+
+bool LinearConstraints::findFeasible(double * x, const Vector & xMin, const Vector & xMax) const
+{
+    const uint32_t equalityCount = equalityB.size();
+    const uint32_t inequalityCount = inequalityB.size();
+    Vector completed(n);
+
+    for (uint32_t sweep = 0; sweep < MAX_PROJECTION_SWEEPS; sweep++)
+    {
+        std::copy(x, x + n, std::begin(completed));
+        complete(&completed[0]);
+        if (feasible(&completed[0]))
+        {
+            std::copy(std::begin(completed), std::end(completed), x);
+            return true;
+        }
+
+        // project onto each violated constraint in turn, then onto the box
+        for (uint32_t r = 0; r < equalityCount + inequalityCount; r++)
+        {
+            const bool equality = r < equalityCount;
+            const double * a = equality ? &equalityA[size_t(r) * n] : &inequalityA[size_t(r - equalityCount) * n];
+            const double b = equality ? equalityB[r] : inequalityB[r - equalityCount];
+
+            const double residual = dot(a, x, n) - b;
+            if (residual <= 0 && !equality)
+                continue;
+            const double norm2 = dot(a, a, n);
+            if (norm2 == 0)
+                continue;
+            for (uint32_t k = 0; k < n; k++)
+                x[k] -= residual / norm2 * a[k];
+        }
+        for (uint32_t k = 0; k < n; k++)
+            x[k] = std::min(std::max(x[k], xMin[k]), xMax[k]);
+    }
+    return false;
+}
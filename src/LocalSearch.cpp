@@ -0,0 +1,204 @@
+#include "LocalSearch.h"
+
+#include <algorithm>
+#include <cmath>
+
+uint32_t NelderMead::minimize(const BatchObjectiveFunction & objective, double * x, double & value,
+                              const double * xMin, const double * xMax, const double * step,
+                              const uint32_t n, const uint32_t maxEvaluations)
+{
+    // the simplex costs n evaluations, then at least one step
+    if (n == 0 || maxEvaluations < n + 1)
+        return 0;
+
+    // Gao and Han coefficients, the classic ones (1, 2, 0.5, 0.5) for n <= 2
+    const double N = std::max(n, 2u);
+    const double EXPAND = 1.0 + 2.0 / N;
+    const double CONTRACT = 0.75 - 0.5 / N;
+    const double SHRINK = 1.0 - 1.0 / N;
+
+    simplex.resize(n + 1, n);
+    values.resize(n + 1);
+    trial.resize(2, n);
+    centroid.resize(n);
+
+    // =============================================
+    // ============== Initial simplex ==============
+    // =============================================
+
+    std::copy(x, x + n, simplex.row(0));
+    values[0] = value;
+    for (uint32_t i = 1; i <= n; i++)
+    {
+        double * vertex = simplex.row(i);
+        std::copy(x, x + n, vertex);
+        const double d = step[i - 1];
+        vertex[i - 1] += vertex[i - 1] + d <= xMax[i - 1] ? d : -d;
+        vertex[i - 1] = std::max(vertex[i - 1], xMin[i - 1]);
+    }
+    objective(simplex.view(1, n + 1), &values[1]);
+    uint32_t evaluations = n;
+
+    // =============================================
+    // ================= Iterations ================
+    // =============================================
+
+    while (evaluations < maxEvaluations)
+    {
+        uint32_t best = 0;
+        uint32_t worst = 0;
+        for (uint32_t i = 1; i <= n; i++)
+        {
+            if (values[i] < values[best])
+                best = i;
+            if (values[i] > values[worst])
+                worst = i;
+        }
+        uint32_t secondWorst = best;
+        for (uint32_t i = 0; i <= n; i++)
+        {
+            if (i != worst && values[i] > values[secondWorst])
+                secondWorst = i;
+        }
+
+        // converged: equal values and a simplex collapsed to the precision of the coordinates
+        // (equal values alone can be a symmetric simplex around the minimum)
+        if (values[worst] - values[best] <= 1e-15 * std::abs(values[best]) && collapsed(best, n))
+            break;
+
+        const double * xWorst = simplex.row(worst);
+        std::fill(centroid.begin(), centroid.end(), 0.0);
+        for (uint32_t i = 0; i <= n; i++)
+        {
+            if (i == worst)
+                continue;
+            const double * vertex = simplex.row(i);
+            for (uint32_t k = 0; k < n; k++)
+                centroid[k] += vertex[k];
+        }
+        for (uint32_t k = 0; k < n; k++)
+            centroid[k] /= n;
+
+        // reflection
+        double * reflected = trial.row(0);
+        for (uint32_t k = 0; k < n; k++)
+            reflected[k] = 2 * centroid[k] - xWorst[k];
+        const double reflectedValue = evaluateTrial(objective, 0, xMin, xMax);
+        evaluations++;
+
+        const double * accepted = nullptr;
+        double acceptedValue = 0;
+        if (reflectedValue < values[best])
+        {
+            accepted = reflected;
+            acceptedValue = reflectedValue;
+
+            if (evaluations < maxEvaluations)
+            {
+                double * expanded = trial.row(1);
+                for (uint32_t k = 0; k < n; k++)
+                    expanded[k] = centroid[k] + EXPAND * (reflected[k] - centroid[k]);
+                const double expandedValue = evaluateTrial(objective, 1, xMin, xMax);
+                evaluations++;
+
+                if (expandedValue < reflectedValue)
+                {
+                    accepted = expanded;
+                    acceptedValue = expandedValue;
+                }
+            }
+        }
+        else if (reflectedValue < values[secondWorst])
+        {
+            accepted = reflected;
+            acceptedValue = reflectedValue;
+        }
+        else if (evaluations < maxEvaluations)
+        {
+            // contraction outside (towards the reflected point) or inside (towards the worst)
+            const bool outside = reflectedValue < values[worst];
+            const double * target = outside ? reflected : xWorst;
+            double * contracted = trial.row(1);
+            for (uint32_t k = 0; k < n; k++)
+                contracted[k] = centroid[k] + CONTRACT * (target[k] - centroid[k]);
+            const double contractedValue = evaluateTrial(objective, 1, xMin, xMax);
+            evaluations++;
+
+            if (outside ? contractedValue <= reflectedValue : contractedValue < values[worst])
+            {
+                accepted = contracted;
+                acceptedValue = contractedValue;
+            }
+        }
+        else
+        {
+            break;
+        }
+
+        if (accepted != nullptr)
+        {
+            std::copy(accepted, accepted + n, simplex.row(worst));
+            values[worst] = acceptedValue;
+            continue;
+        }
+
+        // shrink towards the best vertex, moved to row 0 so that the others are evaluated in one call
+        if (evaluations + n > maxEvaluations)
+            break;
+
+        if (best != 0)
+        {
+            std::swap_ranges(simplex.row(0), simplex.row(0) + n, simplex.row(best));
+            std::swap(values[0], values[best]);
+        }
+        const double * xBest = simplex.row(0);
+        for (uint32_t i = 1; i <= n; i++)
+        {
+            double * vertex = simplex.row(i);
+            for (uint32_t k = 0; k < n; k++)
+                vertex[k] = xBest[k] + SHRINK * (vertex[k] - xBest[k]);
+        }
+        objective(simplex.view(1, n + 1), &values[1]);
+        evaluations += n;
+    }
+
+    uint32_t best = 0;
+    for (uint32_t i = 1; i <= n; i++)
+    {
+        if (values[i] < values[best])
+            best = i;
+    }
+    if (values[best] < value)
+    {
+        std::copy(simplex.row(best), simplex.row(best) + n, x);
+        value = values[best];
+    }
+    return evaluations;
+}
+
+bool NelderMead::collapsed(const uint32_t best, const uint32_t n) const
+{
+    const double * xBest = simplex.row(best);
+    for (uint32_t i = 0; i <= n; i++)
+    {
+        const double * vertex = simplex.row(i);
+        for (uint32_t k = 0; k < n; k++)
+        {
+            if (std::abs(vertex[k] - xBest[k]) > 1e-15 * std::max(1.0, std::abs(xBest[k])))
+                return false;
+        }
+    }
+    return true;
+}
+
+double NelderMead::evaluateTrial(const BatchObjectiveFunction & objective, const uint32_t row,
+                                 const double * xMin, const double * xMax)
+{
+    double * x = trial.row(row);
+    for (uint32_t k = 0; k < trial.cols(); k++)
+        x[k] = std::min(std::max(x[k], xMin[k]), xMax[k]);
+
+    double result;
+    objective(trial.view(row, row + 1), &result);
+    return result;
+}
@@ -0,0 +1,111 @@
+#include "Objectives.h"
+
+#include <cmath>
+
+static const double PI = 3.14159265359;
+
+double objFunc1(const Vector & x)
+{
+    double val = x[0] + x[0] * std::sin(20 * x[0]);
+    return val;
+}
+
+double banana(const Vector & vec)
+{
+    const double a = 1;
+    const double b = 100;
+
+    double val = 0;
+    for (uint32_t i = 0; i + 1 < vec.size(); i++)
+    {
+        const double x = vec[i];
+        const double y = vec[i + 1];
+        val += (a - x) * (a - x) + b * (y - x * x) * (y - x * x);
+    }
+    return val;
+}
+
+double himmelblau(const Vector & vec)
+{
+    double val = 0;
+    for (uint32_t i = 0; i + 1 < vec.size(); i += 2)
+    {
+        const double x = vec[i];
+        const double y = vec[i + 1];
+        const double u = x * x + y - 11;
+        const double v = x + y * y - 7;
+        val += u * u + v * v;
+    }
+    return val;
+}
+
+double levi13(const Vector & vec)
+{
+    const double s = std::sin(3 * PI * vec[0]);
+    double val = s * s;
+    for (uint32_t i = 0; i + 1 < vec.size(); i++)
+    {
+        const double x = vec[i];
+        const double y = vec[i + 1];
+        const double sx = std::sin(3 * PI * x);
+        const double sy = std::sin(3 * PI * y);
+        val += (x - 1) * (x - 1) * (1 + sy * sy) + (y - 1) * (y - 1) * (1 + sx * sx);
+    }
+    return val;
+}
+
+double f2d(const Vector & vec)
+{
+    double x = vec[0];
+    double y = vec[1];
+    double sum = x * x + 10.0 * y * y;
+    double val = sum * sum;
+    //double val = std::pow(x + 10.0 * y, 2);
+    return val;
+}
+
+double rastrigin(const Vector & vec)
+{
+    const double a = 10;
+
+    double val = a * vec.size();
+    for (auto x : vec)
+        val += x * x - a * std::cos(2 * PI * x);
+    return val;
+}
+
+double sphere(const Vector & vec)
+{
+    double val = 0;
+    for (auto x : vec)
+        val += x * x;
+    return val;
+}
+
+double ackley(const Vector & vec)
+{
+    const double n = vec.size();
+
+    double sumSq = 0;
+    double sumCos = 0;
+    for (auto x : vec)
+    {
+        sumSq += x * x;
+        sumCos += std::cos(2 * PI * x);
+    }
+
+    return -20.0 * std::exp(-0.2 * std::sqrt(sumSq / n)) - std::exp(sumCos / n) + 20.0 + std::exp(1.0);
+}
+
+double griewank(const Vector & vec)
+{
+    double sum = 0;
+    double product = 1;
+    for (uint32_t i = 0; i < vec.size(); i++)
+    {
+        sum += vec[i] * vec[i];
+        product *= std::cos(vec[i] / std::sqrt(i + 1.0));
+    }
+
+    return 1.0 + sum / 4000.0 - product;
+}
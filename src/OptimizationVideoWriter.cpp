@@ -1,61 +1,507 @@
 #include "OptimizationVideoWriter.h"
 
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
 void OptimizationVideoWriter::drawBackground(ObjectiveFunction objFun, const double gamma)
 {
-    cv::Mat functionValues(HEIGHT, WIDTH, CV_64FC1);
+    drawBackground(makeBatchObjective(objFun), gamma, BackgroundOptions());
+}
 
-    double minVal = 1e99;
-    double maxVal = -1e99;
+void OptimizationVideoWriter::drawBackground(BatchObjectiveFunction objFun, const double gamma,
+                                             const BackgroundOptions & options)
+{
+    // queued frames are drawn over the old background
+    flush();
 
-    for (uint32_t y = 0; y < HEIGHT; y++)
+    const uint32_t threadCount = options.threadCount > 0 ? options.threadCount : std::max(1u, std::thread::hardware_concurrency());
+    this->activePool = nullptr;
+    if (threadCount > 1)
     {
-        const double vectorY = y / Y_SCALE + Y_OFFSET;
-        double * line = functionValues.ptr<double>(y);
-
-        for (uint32_t x = 0; x < WIDTH; x++)
+        if (!this->threadPool || this->threadPool->size() != threadCount)
         {
-            const double vectorX = x / X_SCALE + X_OFFSET;
-            Vector vec = {vectorX, vectorY};
+            this->threadPool.reset(new ThreadPool(threadCount));
+        }
+        this->activePool = this->threadPool.get();
+    }
+    rowPoints.resize(threadCount);
+    rowValues.resize(threadCount);
+    threadMin.resize(threadCount);
+    threadMax.resize(threadCount);
 
-            const double val = objFun(vec);
-            minVal = std::min(minVal, val);
-            maxVal = std::max(maxVal, val);
+    backgroundValues.create(HEIGHT, WIDTH, CV_64FC1);
 
-            line[x] = val;
+    // coarse to fine: level 0 is the full resolution
+    const uint32_t levels = std::min(options.coarseLevels, 30u);
+    for (uint32_t level = levels + 1; level-- > 0;)
+    {
+        const uint32_t stride = 1u << level;
+        evaluateBackground(objFun, stride, level == levels, std::max(1u, options.tileRows));
+        renderBackground(stride, gamma);
+
+        if (level > 0 && options.preview)
+        {
+            options.preview(this->backgroundImg, level);
         }
     }
+}
+
+void OptimizationVideoWriter::evaluateBackground(const BatchObjectiveFunction & objFun, const uint32_t stride,
+                                                 const bool first, const uint32_t tileRows)
+{
+    const uint32_t tileCount = (HEIGHT + tileRows - 1) / tileRows;
+    parallelFor(tileCount, [&](uint32_t begin, uint32_t end, uint32_t threadIdx)
+    {
+        std::vector<double> & points = rowPoints[threadIdx];
+        std::vector<double> & values = rowValues[threadIdx];
+
+        for (uint32_t y = begin * tileRows; y < std::min(HEIGHT, end * tileRows); y++)
+        {
+            if (y % stride != 0)
+                continue;
+
+            // rows of the previous pass only miss the odd multiples of stride
+            const bool previousRow = !first && y % (2 * stride) == 0;
+            const uint32_t xStart = previousRow ? stride : 0;
+            const uint32_t xStep = previousRow ? 2 * stride : stride;
+            if (xStart >= WIDTH)
+                continue;
+            const uint32_t count = (WIDTH - 1 - xStart) / xStep + 1;
+
+            const double vectorY = y / Y_SCALE + Y_OFFSET;
+            points.resize(2 * size_t(count));
+            values.resize(count);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                points[2 * i] = (xStart + i * xStep) / X_SCALE + X_OFFSET;
+                points[2 * i + 1] = vectorY;
+            }
+
+            objFun(PopulationMatrix{&points[0], count, 2, 2}, &values[0]);
+
+            double * line = backgroundValues.ptr<double>(y);
+            for (uint32_t i = 0; i < count; i++)
+                line[xStart + i * xStep] = values[i];
+        }
+    }, 1);
+}
 
-    // normalize to 0..1
-    functionValues -= minVal;
-    functionValues *= 1.0 / (maxVal - minVal);
+void OptimizationVideoWriter::renderBackground(const uint32_t stride, const double gamma)
+{
+    const uint32_t tileRows = 16;
+    const uint32_t tileCount = (HEIGHT + tileRows - 1) / tileRows;
 
-    // apply gamma
-    cv::pow(functionValues, gamma, functionValues);
+    // range of the samples
+    std::fill(threadMin.begin(), threadMin.end(), 1e99);
+    std::fill(threadMax.begin(), threadMax.end(), -1e99);
+    parallelFor(tileCount, [&](uint32_t begin, uint32_t end, uint32_t threadIdx)
+    {
+        double minVal = threadMin[threadIdx];
+        double maxVal = threadMax[threadIdx];
+        for (uint32_t y = begin * tileRows; y < std::min(HEIGHT, end * tileRows); y++)
+        {
+            if (y % stride != 0)
+                continue;
+            const double * line = backgroundValues.ptr<double>(y);
+            for (uint32_t x = 0; x < WIDTH; x += stride)
+            {
+                minVal = std::min(minVal, line[x]);
+                maxVal = std::max(maxVal, line[x]);
+            }
+        }
+        threadMin[threadIdx] = minVal;
+        threadMax[threadIdx] = maxVal;
+    }, 1);
+    const double minVal = *std::min_element(threadMin.begin(), threadMin.end());
+    const double maxVal = *std::max_element(threadMax.begin(), threadMax.end());
+    const double scale = maxVal > minVal ? 1.0 / (maxVal - minVal) : 0.0;
+
+    // normalize to 0..1, apply gamma, gray levels
+    parallelFor(tileCount, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for (uint32_t y = begin * tileRows; y < std::min(HEIGHT, end * tileRows); y++)
+        {
+            const double * line = backgroundValues.ptr<double>(y - y % stride);
+            uint8_t * pixels = backgroundImg.ptr<uint8_t>(y);
+            for (uint32_t x = 0; x < WIDTH; x++)
+            {
+                const double value = std::pow((line[x - x % stride] - minVal) * scale, gamma);
+                const uint8_t gray = uint8_t(std::min(std::max(std::lrint(value * 255.0), 0l), 255l));
+                pixels[3 * x] = gray;
+                pixels[3 * x + 1] = gray;
+                pixels[3 * x + 2] = gray;
+            }
+        }
+    }, 1);
 
-    cv::Mat temp;
-    functionValues.convertTo(temp, CV_8UC1, 255.0);
-    cv::cvtColor(temp, this->backgroundImg, cv::COLOR_GRAY2BGR);
     drawGrid();
 }
 
-void OptimizationVideoWriter::drawFrame(const std::vector<Genocop::Score> & population)
+OptimizationVideoWriter::~OptimizationVideoWriter()
+{
+    end();
+}
+
+bool OptimizationVideoWriter::drawFrame(const std::vector<Genocop::Score> & population)
 {
-    cv::Mat image = this->backgroundImg.clone();
-    for (auto & score : population)
+    return queueFrame([&](FrameSlot & slot) { capture(population, slot); });
+}
+
+bool OptimizationVideoWriter::drawFrame(const Genocop::PopulationView & population)
+{
+    return queueFrame([&](FrameSlot & slot) { capture(population, slot); });
+}
+
+template <class Capture>
+bool OptimizationVideoWriter::queueFrame(const Capture & capture)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!running)
     {
-        const double x = score.x[0];
-        const double y = score.x[1];
+        lock.unlock();
+        capture(directFrame);
+        rasterize(directFrame);
+        this->videoWriter << directFrame.image;
+        writtenCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
 
-        cv::Point2f pt(float((x - X_OFFSET) * X_SCALE), float((y - Y_OFFSET) * Y_SCALE));
-        cv::circle(image, pt, 2, cv::Scalar(0, 0, 255), cv::FILLED);
+    FrameSlot & slot = slots[nextFrame % slots.size()];
+    if (slot.state != FrameSlot::Free)
+    {
+        if (pipeline.backpressure == Backpressure::Drop)
+        {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        condition.wait(lock, [&slot]() { return slot.state == FrameSlot::Free; });
     }
 
-    this->videoWriter << image;
+    // the slot belongs to this thread until it's queued
+    lock.unlock();
+    capture(slot);
+    lock.lock();
+
+    slot.state = FrameSlot::Queued;
+    nextFrame++;
+    lock.unlock();
+    condition.notify_all();
+    return true;
 }
 
 void OptimizationVideoWriter::begin(const std::string & filename)
 {
+    begin(filename, PipelineOptions());
+}
+
+void OptimizationVideoWriter::begin(const std::string & filename, const PipelineOptions & options)
+{
+    end();
+
     this->videoWriter.open(filename, cv::VideoWriter::fourcc('m', 'p', '4', 'v'), 2, cv::Size(WIDTH, HEIGHT));
+
+    pipeline = options;
+    pipeline.queueFrames = std::max(1u, options.queueFrames);
+    pipeline.rasterThreads = std::max(1u, options.rasterThreads);
+    if (slots.size() != pipeline.queueFrames)
+    {
+        slots.clear();
+        slots.resize(pipeline.queueFrames);
+    }
+
+    nextFrame = 0;
+    nextDraw = 0;
+    nextEncode = 0;
+    trajectory.clear();
+    trajectoryGenomes.clear();
+    trajectoryBest = 1e+99;
+    stopping = false;
+    running = true;
+    for (uint32_t i = 0; i < pipeline.rasterThreads; i++)
+    {
+        rasterThreads.emplace_back(&OptimizationVideoWriter::rasterLoop, this);
+    }
+    encoderThread = std::thread(&OptimizationVideoWriter::encoderLoop, this);
+}
+
+void OptimizationVideoWriter::setFrameOptions(const FrameOptions & options)
+{
+    flush();
+    frameOptions = options;
+}
+
+void OptimizationVideoWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [this]() { return nextEncode == nextFrame; });
+}
+
+void OptimizationVideoWriter::end()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running)
+            return;
+        stopping = true;
+    }
+    condition.notify_all();
+
+    for (auto & thread : rasterThreads)
+    {
+        thread.join();
+    }
+    rasterThreads.clear();
+    encoderThread.join();
+
+    running = false;
+    this->videoWriter.release();
+}
+
+void OptimizationVideoWriter::rasterLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        condition.wait(lock, [this]() { return nextDraw < nextFrame || stopping; });
+        if (nextDraw == nextFrame)
+            return; // stopping and everything drawn
+
+        FrameSlot & slot = slots[nextDraw % slots.size()];
+        nextDraw++;
+        slot.state = FrameSlot::Drawing;
+
+        lock.unlock();
+        rasterize(slot);
+        lock.lock();
+
+        slot.state = FrameSlot::Drawn;
+        condition.notify_all();
+    }
+}
+
+void OptimizationVideoWriter::encoderLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        condition.wait(lock, [this]()
+        {
+            return (nextEncode < nextFrame && slots[nextEncode % slots.size()].state == FrameSlot::Drawn)
+                   || (stopping && nextEncode == nextFrame);
+        });
+        if (nextEncode == nextFrame)
+            return; // stopping and everything written
+
+        FrameSlot & slot = slots[nextEncode % slots.size()];
+
+        lock.unlock();
+        this->videoWriter << slot.image;
+        writtenCount.fetch_add(1, std::memory_order_relaxed);
+        lock.lock();
+
+        slot.state = FrameSlot::Free;
+        nextEncode++;
+        condition.notify_all();
+    }
+}
+
+void OptimizationVideoWriter::capture(const std::vector<Genocop::Score> & population, FrameSlot & slot)
+{
+    if (population.empty())
+    {
+        slot.points.clear();
+        return;
+    }
+    const uint32_t cols = population[0].x.size();
+    checkGenomeSize(cols);
+    for (const auto & score : population)
+    {
+        if (score.x.size() != cols)
+        {
+            throw std::runtime_error("Individuals of different sizes!");
+        }
+    }
+
+    // the projection needs contiguous rows
+    if (this->projection != nullptr)
+    {
+        packedRows.resize(population.size() * cols);
+        for (size_t i = 0; i < population.size(); i++)
+            std::copy(std::begin(population[i].x), std::end(population[i].x), &packedRows[i * cols]);
+        this->projection->update(PopulationMatrix{&packedRows[0], uint32_t(population.size()), cols, cols});
+    }
+
+    size_t best = 0;
+    slot.points.resize(population.size());
+    for (size_t i = 0; i < population.size(); i++)
+    {
+        slot.points[i] = toImage(this->projection != nullptr ? &packedRows[i * cols] : &population[i].x[0]);
+        if (population[i].value < population[best].value)
+            best = i;
+    }
+
+    if (frameOptions.trajectory)
+    {
+        extendTrajectory(population[best].value, &population[best].x[0], cols);
+        slot.trajectory = trajectory;
+    }
+}
+
+void OptimizationVideoWriter::capture(const Genocop::PopulationView & population, FrameSlot & slot)
+{
+    checkGenomeSize(population.genomes.cols);
+    if (this->projection != nullptr)
+    {
+        this->projection->update(population.genomes);
+    }
+
+    slot.points.resize(population.size());
+    for (uint32_t i = 0; i < population.size(); i++)
+    {
+        slot.points[i] = toImage(population.genomes.row(i));
+    }
+
+    if (frameOptions.trajectory)
+    {
+        // a new run starts a new trajectory
+        if (population.iteration == 0)
+        {
+            trajectory.clear();
+            trajectoryGenomes.clear();
+            trajectoryBest = 1e+99;
+        }
+        extendTrajectory(population.bestValue, population.bestSolution, population.genomes.cols);
+        slot.trajectory = trajectory;
+    }
+}
+
+void OptimizationVideoWriter::checkGenomeSize(const uint32_t cols) const
+{
+    if (this->projection != nullptr && cols != this->projection->dimension())
+    {
+        throw std::runtime_error("Genomes of a different dimension than the projection!");
+    }
+    if (this->projection == nullptr && cols < 2)
+    {
+        throw std::runtime_error("Genomes of less than 2 genes need a projection!");
+    }
+}
+
+cv::Point2f OptimizationVideoWriter::toImage(const double * x) const
+{
+    double px = x[0];
+    double py = x[1];
+    if (this->projection != nullptr)
+    {
+        this->projection->project(x, px, py);
+    }
+    return cv::Point2f(float((px - X_OFFSET) * X_SCALE), float((py - Y_OFFSET) * Y_SCALE));
+}
+
+void OptimizationVideoWriter::extendTrajectory(const double value, const double * x, const uint32_t cols)
+{
+    if (value < trajectoryBest)
+    {
+        trajectoryBest = value;
+        trajectoryGenomes.insert(trajectoryGenomes.end(), x, x + cols);
+        if (this->projection == nullptr)
+            addTrajectoryPoint(x);
+    }
+
+    // the projection was updated for this frame
+    if (this->projection != nullptr)
+    {
+        trajectory.clear();
+        for (size_t i = 0; i < trajectoryGenomes.size(); i += cols)
+            addTrajectoryPoint(&trajectoryGenomes[i]);
+    }
+}
+
+void OptimizationVideoWriter::addTrajectoryPoint(const double * x)
+{
+    const cv::Point2f pt = toImage(x);
+    const cv::Point point(int(std::lrint(pt.x)), int(std::lrint(pt.y)));
+    if (trajectory.empty() || trajectory.back().x != point.x || trajectory.back().y != point.y)
+        trajectory.push_back(point);
+}
+
+void OptimizationVideoWriter::rasterize(FrameSlot & slot) const
+{
+    this->backgroundImg.copyTo(slot.image);
+    if (frameOptions.style == FrameStyle::Density)
+    {
+        drawDensity(slot);
+    }
+    else
+    {
+        for (auto & pt : slot.points)
+        {
+            cv::circle(slot.image, pt, 2, cv::Scalar(0, 0, 255), cv::FILLED);
+        }
+    }
+
+    if (frameOptions.trajectory && !slot.trajectory.empty())
+    {
+        const cv::Scalar trajectoryColor(255, 255, 0);
+        cv::polylines(slot.image, slot.trajectory, false, trajectoryColor, 2, cv::LINE_AA);
+        cv::circle(slot.image, slot.trajectory.back(), 4, trajectoryColor, cv::FILLED);
+    }
+}
+
+void OptimizationVideoWriter::drawDensity(FrameSlot & slot) const
+{
+    const uint32_t cell = std::max(1u, frameOptions.cellSize);
+    const uint32_t cols = (WIDTH + cell - 1) / cell;
+    const uint32_t rows = (HEIGHT + cell - 1) / cell;
+
+    // scatter-add
+    slot.histogram.assign(size_t(cols) * rows, 0);
+    for (auto & pt : slot.points)
+    {
+        const int x = int(std::lrint(pt.x));
+        const int y = int(std::lrint(pt.y));
+        if (x < 0 || y < 0 || x >= int(WIDTH) || y >= int(HEIGHT))
+            continue;
+        slot.histogram[size_t(y / cell) * cols + x / cell]++;
+    }
+    const uint32_t maxCount = *std::max_element(slot.histogram.begin(), slot.histogram.end());
+    if (maxCount == 0)
+        return;
+
+    // log scale: single individuals stay visible next to crowded cells
+    slot.levels.create(rows, cols, CV_8UC1);
+    const double scale = 255.0 / std::log1p(double(maxCount));
+    for (uint32_t cy = 0; cy < rows; cy++)
+    {
+        uint8_t * line = slot.levels.ptr<uint8_t>(cy);
+        for (uint32_t cx = 0; cx < cols; cx++)
+            line[cx] = uint8_t(std::lrint(std::log1p(double(slot.histogram[size_t(cy) * cols + cx])) * scale));
+    }
+    cv::applyColorMap(slot.levels, slot.colors, frameOptions.colormap);
+
+    // blend the occupied cells over the background
+    const uint32_t alpha = uint32_t(std::lrint(std::min(std::max(frameOptions.opacity, 0.0), 1.0) * 256));
+    for (uint32_t cy = 0; cy < rows; cy++)
+    {
+        const uint8_t * colorLine = slot.colors.ptr<uint8_t>(cy);
+        for (uint32_t cx = 0; cx < cols; cx++)
+        {
+            if (slot.histogram[size_t(cy) * cols + cx] == 0)
+                continue;
+
+            const uint8_t * color = colorLine + 3 * cx;
+            for (uint32_t y = cy * cell; y < std::min(HEIGHT, (cy + 1) * cell); y++)
+            {
+                uint8_t * pixels = slot.image.ptr<uint8_t>(y);
+                for (uint32_t x = cx * cell; x < std::min(WIDTH, (cx + 1) * cell); x++)
+                {
+                    for (uint32_t c = 0; c < 3; c++)
+                        pixels[3 * x + c] = uint8_t((pixels[3 * x + c] * (256 - alpha) + color[c] * alpha) >> 8);
+                }
+            }
+        }
+    }
 }
 
 void OptimizationVideoWriter::drawGrid()
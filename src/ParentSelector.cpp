@@ -0,0 +1,218 @@
+#include "ParentSelector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+void ParentSelector::prepare(const std::vector<double> & scores, const Settings & settings)
+{
+    this->settings = settings;
+    const uint32_t N = scores.size();
+    if (N == 0)
+    {
+        throw std::runtime_error("Empty population!");
+    }
+
+    // ================================================================
+    // ============================ Ranking ===========================
+    // ================================================================
+
+    if (ranks.size() != N)
+    {
+        ranks.resize(N);
+    }
+    for (uint32_t i = 0; i < N; i++)
+    {
+        ranks[i] = i;
+    }
+
+    // the only sort per generation; index tie break keeps the order independent of the sort algorithm
+    std::sort(ranks.begin(), ranks.end(), [&](uint32_t a, uint32_t b)
+    {
+        return scores[a] < scores[b] || (scores[a] == scores[b] && a < b);
+    });
+
+    // distributions only need to be recomputed when the population size or the settings change
+    const bool resized = N != populationCount;
+    populationCount = N;
+
+    // ================================================================
+    // ========================== Tournament ==========================
+    // ================================================================
+
+    if (settings.method == Method::Tournament)
+    {
+        const uint32_t k = std::max(1u, std::min(settings.tournamentSize, N));
+        tournamentCdf.resize(k);
+
+        // truncated geometric distribution: participant i (0 = best) wins with probability p * (1 - p)^i,
+        // the last one wins if nobody else did
+        const double p = settings.tournamentP;
+        double notWon = 1.0;
+        for (uint32_t i = 0; i + 1 < k; i++)
+        {
+            notWon *= 1.0 - p;
+            tournamentCdf[i] = 1.0 - notWon;
+        }
+        tournamentCdf[k - 1] = 1.0;
+    }
+
+    // ================================================================
+    // ======================== Linear ranking ========================
+    // ================================================================
+
+    if ((settings.method == Method::LinearRanking || settings.method == Method::StochasticUniversal) &&
+        (resized || rankingCdf.empty() || settings.rankingPressure != rankingPressure))
+    {
+        rankingPressure = settings.rankingPressure;
+        const double s = std::min(2.0, std::max(1.0, settings.rankingPressure));
+        rankingCdf.resize(N);
+
+        // p(r) = (s - 2 * (s - 1) * r / (N - 1)) / N, r = 0 is the best
+        double sum = 0;
+        for (uint32_t r = 0; r < N; r++)
+        {
+            const double t = N > 1 ? double(r) / (N - 1) : 0.0;
+            sum += (s - 2 * (s - 1) * t) / N;
+            rankingCdf[r] = sum;
+        }
+        // remove rounding errors
+        for (uint32_t r = 0; r < N; r++)
+        {
+            rankingCdf[r] /= sum;
+        }
+        rankingCdf[N - 1] = 1.0;
+    }
+
+    // ================================================================
+    // ========================== Truncation ==========================
+    // ================================================================
+
+    const double fraction = std::min(1.0, std::max(0.0, settings.truncationFraction));
+    truncationCount = std::max(1u, std::min(N, uint32_t(std::ceil(fraction * N))));
+}
+
+void ParentSelector::rerank(const std::vector<double> & scores, const uint32_t idx)
+{
+    auto better = [&](uint32_t a, uint32_t b)
+    {
+        return scores[a] < scores[b] || (scores[a] == scores[b] && a < b);
+    };
+
+    const auto current = std::find(ranks.begin(), ranks.end(), idx);
+    if (current == ranks.end())
+        return;
+
+    // the other ranks are still sorted: find the new place and rotate the elements in between
+    if (current != ranks.begin() && better(idx, *(current - 1)))
+    {
+        const auto place = std::upper_bound(ranks.begin(), current, idx, better);
+        std::rotate(place, current, current + 1);
+    }
+    else if (current + 1 != ranks.end() && better(*(current + 1), idx))
+    {
+        const auto place = std::lower_bound(current + 1, ranks.end(), idx, better);
+        std::rotate(current, current + 1, place);
+    }
+}
+
+void ParentSelector::select(std::vector<uint32_t> & outParents, Engine & rng) const
+{
+    if (settings.method == Method::StochasticUniversal)
+    {
+        stochasticUniversal(outParents, rng);
+        return;
+    }
+
+    for (uint32_t i = 0; i < outParents.size(); i++)
+    {
+        outParents[i] = selectOne(rng);
+    }
+}
+
+uint32_t ParentSelector::selectOne(Engine & rng) const
+{
+    switch (settings.method)
+    {
+    case Method::Tournament:
+        return runTournament(rng);
+    case Method::LinearRanking:
+        return sampleRanking(rng);
+    case Method::Truncation:
+        return ranks[rng.index(truncationCount)];
+    default:
+        throw std::runtime_error("Selection method can't select single parents!");
+    }
+}
+
+uint32_t ParentSelector::runTournament(Engine & rng) const
+{
+    const uint32_t N = populationCount;
+    const uint32_t k = tournamentCdf.size();
+
+    // decide which place wins before looking at the participants
+    const double u = rng.uniform();
+    uint32_t place = 0;
+    while (place + 1 < k && u >= tournamentCdf[place])
+    {
+        place++;
+    }
+
+    if (k == N)
+    {
+        // everybody participates
+        return ranks[place];
+    }
+
+    // sample k distinct ranks (Floyd's algorithm - exactly k draws)
+    const uint32_t STACK_SIZE = 64;
+    uint32_t stackBuffer[STACK_SIZE];
+    static thread_local std::vector<uint32_t> heapBuffer;
+    uint32_t * sample = stackBuffer;
+    if (k > STACK_SIZE)
+    {
+        heapBuffer.resize(k);
+        sample = heapBuffer.data();
+    }
+
+    for (uint32_t i = 0; i < k; i++)
+    {
+        const uint32_t j = N - k + i;
+        const uint32_t t = rng.index(j + 1);
+        const bool taken = std::find(sample, sample + i, t) != sample + i;
+        sample[i] = taken ? j : t;
+    }
+
+    // ranks are ordered by score, so the participant at the winning place is the place-th smallest rank
+    std::nth_element(sample, sample + place, sample + k);
+    return ranks[sample[place]];
+}
+
+uint32_t ParentSelector::sampleRanking(Engine & rng) const
+{
+    const double u = rng.uniform();
+    const uint32_t r = std::upper_bound(rankingCdf.begin(), rankingCdf.end(), u) - rankingCdf.begin();
+    return ranks[std::min(r, populationCount - 1)];
+}
+
+void ParentSelector::stochasticUniversal(std::vector<uint32_t> & outParents, Engine & rng) const
+{
+    const uint32_t COUNT = outParents.size();
+    if (COUNT == 0)
+        return;
+
+    // COUNT equally spaced pointers with a random start
+    const double step = 1.0 / COUNT;
+    double pointer = rng.uniform() * step;
+
+    uint32_t r = 0;
+    for (uint32_t i = 0; i < COUNT; i++)
+    {
+        while (r + 1 < populationCount && rankingCdf[r] <= pointer)
+        {
+            r++;
+        }
+        outParents[i] = ranks[r];
+        pointer += step;
+    }
+}
@@ -0,0 +1,159 @@
+#include "PopulationProjection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "Random.h"
+
+PopulationProjection::PopulationProjection(const Vector & xMin, const Vector & xMax) :
+    PopulationProjection(xMin, xMax, Options())
+{
+}
+
+PopulationProjection::PopulationProjection(const Vector & xMin, const Vector & xMax, const Options & options) :
+    n(xMin.size()), options(options)
+{
+    if (xMax.size() != n || n == 0)
+    {
+        throw std::runtime_error("Invalid projection bounds!");
+    }
+
+    center.resize(n);
+    invScale.resize(n);
+    for (uint32_t k = 0; k < n; k++)
+    {
+        center[k] = 0.5 * (xMin[k] + xMax[k]);
+        invScale[k] = xMax[k] > xMin[k] ? 2.0 / (xMax[k] - xMin[k]) : 0.0;
+    }
+
+    // random gaussian directions are uniformly distributed
+    axes.assign(2 * size_t(n), 0.0);
+    basis.resize(2 * size_t(n));
+    sketch.resize(2 * size_t(n));
+    Random rng(options.seed);
+    rng.fillNormal(&sketch[0], 2 * n);
+    if (!orthonormalize())
+    {
+        axes[0] = 1; // n == 1: the second axis stays 0
+    }
+
+    mean.assign(n, 0.0);
+    batchMean.resize(n);
+    centered.resize(n);
+}
+
+void PopulationProjection::update(const PopulationMatrix & population)
+{
+    if (population.cols != n)
+    {
+        throw std::runtime_error("Population of a different dimension than the projection!");
+    }
+    if (options.method != Method::Pca || population.rows == 0)
+        return;
+
+    const uint32_t N = population.rows;
+    const double memory = updates == 0 ? 0.0 : std::min(std::max(options.memory, 0.0), 1.0);
+
+    std::fill(batchMean.begin(), batchMean.end(), 0.0);
+    for (uint32_t j = 0; j < N; j++)
+    {
+        const double * x = population.row(j);
+        for (uint32_t k = 0; k < n; k++)
+            batchMean[k] += (x[k] - center[k]) * invScale[k];
+    }
+    for (uint32_t k = 0; k < n; k++)
+        mean[k] = memory * mean[k] + (1 - memory) * batchMean[k] / N;
+
+    // sketch = memory * previous sketch + (1 - memory) * covariance of the generation * axes
+    previousSketch = sketch;
+    double * sketch0 = &sketch[0];
+    double * sketch1 = &sketch[n];
+    const double * axis0 = &axes[0];
+    const double * axis1 = &axes[n];
+    for (uint32_t iter = 0; iter < std::max(1u, options.powerIterations); iter++)
+    {
+        for (uint32_t k = 0; k < 2 * n; k++)
+            sketch[k] = memory * previousSketch[k];
+
+        const double weight = (1 - memory) / N;
+        for (uint32_t j = 0; j < N; j++)
+        {
+            const double * x = population.row(j);
+            double p0 = 0;
+            double p1 = 0;
+            for (uint32_t k = 0; k < n; k++)
+            {
+                centered[k] = (x[k] - center[k]) * invScale[k] - mean[k];
+                p0 += centered[k] * axis0[k];
+                p1 += centered[k] * axis1[k];
+            }
+            p0 *= weight;
+            p1 *= weight;
+            for (uint32_t k = 0; k < n; k++)
+            {
+                sketch0[k] += p0 * centered[k];
+                sketch1[k] += p1 * centered[k];
+            }
+        }
+
+        // no spread (converged population): keep the axes
+        if (!orthonormalize())
+        {
+            sketch = previousSketch;
+            break;
+        }
+    }
+    updates++;
+}
+
+bool PopulationProjection::orthonormalize()
+{
+    const double * s0 = &sketch[0];
+    const double * s1 = &sketch[n];
+
+    double norm0 = 0;
+    for (uint32_t k = 0; k < n; k++)
+        norm0 += s0[k] * s0[k];
+    norm0 = std::sqrt(norm0);
+    if (!(norm0 > 1e-150))
+        return false;
+
+    // Gram-Schmidt, twice for the second axis to stay orthogonal to rounding
+    std::vector<double> & q = basis;
+    for (uint32_t k = 0; k < n; k++)
+    {
+        q[k] = s0[k] / norm0;
+        q[n + k] = s1[k];
+    }
+    double norm1 = 0;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        double d = 0;
+        for (uint32_t k = 0; k < n; k++)
+            d += q[k] * q[n + k];
+        norm1 = 0;
+        for (uint32_t k = 0; k < n; k++)
+        {
+            q[n + k] -= d * q[k];
+            norm1 += q[n + k] * q[n + k];
+        }
+        norm1 = std::sqrt(norm1);
+    }
+    if (!(norm1 > 1e-12 * norm0))
+        return false;
+    for (uint32_t k = 0; k < n; k++)
+        q[n + k] /= norm1;
+
+    // keep the orientation of the picture: no flips from one generation to the next
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        double d = 0;
+        for (uint32_t k = 0; k < n; k++)
+            d += q[size_t(i) * n + k] * axes[size_t(i) * n + k];
+        const double sign = d < 0 ? -1.0 : 1.0;
+        for (uint32_t k = 0; k < n; k++)
+            axes[size_t(i) * n + k] = sign * q[size_t(i) * n + k];
+    }
+    return true;
+}
@@ -0,0 +1,191 @@
+#include "Sobol.h"
+
+#include "Random.h"
+
+// Initial direction numbers m_1..m_s of dimensions 2 to 40 (Joe and Kuo, new-joe-kuo-6.21201).
+// Their primitive polynomials are the first ones in order of degree and coefficients,
+// the same order as primitivePolynomials() below
+static const uint32_t JOE_KUO_DIMENSIONS = 39;
+static const uint32_t JOE_KUO_M[JOE_KUO_DIMENSIONS][8] =
+{
+    {1},
+    {1, 3},
+    {1, 3, 1},
+    {1, 1, 1},
+    {1, 1, 3, 3},
+    {1, 3, 5, 13},
+    {1, 1, 5, 5, 17},
+    {1, 1, 5, 5, 5},
+    {1, 1, 7, 11, 19},
+    {1, 1, 5, 1, 1},
+    {1, 1, 1, 3, 11},
+    {1, 3, 5, 5, 31},
+    {1, 3, 3, 9, 7, 49},
+    {1, 1, 1, 15, 21, 21},
+    {1, 3, 1, 13, 27, 49},
+    {1, 1, 1, 15, 7, 5},
+    {1, 3, 1, 15, 13, 25},
+    {1, 1, 5, 5, 19, 61},
+    {1, 3, 7, 11, 23, 15, 103},
+    {1, 3, 7, 13, 13, 15, 69},
+    {1, 1, 3, 13, 7, 35, 63},
+    {1, 3, 5, 9, 1, 25, 53},
+    {1, 3, 1, 13, 9, 35, 107},
+    {1, 3, 1, 5, 27, 61, 31},
+    {1, 1, 5, 11, 19, 41, 61},
+    {1, 3, 5, 3, 3, 13, 69},
+    {1, 1, 7, 13, 1, 19, 1},
+    {1, 3, 7, 5, 13, 19, 59},
+    {1, 1, 3, 9, 25, 29, 41},
+    {1, 3, 5, 13, 23, 1, 55},
+    {1, 3, 7, 3, 13, 59, 17},
+    {1, 3, 1, 3, 5, 53, 69},
+    {1, 1, 5, 5, 23, 33, 13},
+    {1, 1, 7, 7, 1, 61, 123},
+    {1, 1, 7, 9, 13, 61, 49},
+    {1, 3, 3, 5, 3, 55, 33},
+    {1, 3, 1, 15, 31, 13, 49, 245},
+    {1, 3, 5, 15, 31, 59, 63, 97},
+    {1, 3, 1, 11, 11, 11, 77, 249},
+};
+
+// Seed of the initial direction numbers of the dimensions after the table
+static const uint64_t SOBOL_SEED = 0x50B01;
+
+// =============================================
+// ========= Polynomials over GF(2) ============
+// =============================================
+// Bit k is the coefficient of x^k
+
+// a * b mod p, p of degree degree
+static uint64_t mulMod(uint64_t a, uint64_t b, const uint64_t p, const uint32_t degree)
+{
+    uint64_t result = 0;
+    while (b != 0)
+    {
+        if (b & 1)
+            result ^= a;
+        b >>= 1;
+        a <<= 1;
+        if ((a >> degree) & 1)
+            a ^= p;
+    }
+    return result;
+}
+
+// x^e mod p
+static uint64_t powXMod(uint64_t e, const uint64_t p, const uint32_t degree)
+{
+    uint64_t result = 1;
+    uint64_t base = 2;
+    while (e != 0)
+    {
+        if (e & 1)
+            result = mulMod(result, base, p, degree);
+        base = mulMod(base, base, p, degree);
+        e >>= 1;
+    }
+    return result;
+}
+
+// p is primitive if x has order 2^degree - 1 modulo p
+static bool isPrimitive(const uint64_t p, const uint32_t degree, const std::vector<uint64_t> & orderFactors)
+{
+    const uint64_t order = (uint64_t(1) << degree) - 1;
+    if (powXMod(order, p, degree) != 1)
+        return false;
+    for (auto q : orderFactors)
+    {
+        if (powXMod(order / q, p, degree) == 1)
+            return false;
+    }
+    return true;
+}
+
+static std::vector<uint64_t> primeFactors(uint64_t n)
+{
+    std::vector<uint64_t> factors;
+    for (uint64_t d = 2; d * d <= n; d++)
+    {
+        if (n % d == 0)
+        {
+            factors.push_back(d);
+            while (n % d == 0)
+                n /= d;
+        }
+    }
+    if (n > 1)
+        factors.push_back(n);
+    return factors;
+}
+
+// The first count primitive polynomials of degree >= 1, by degree and then by coefficients
+static std::vector<uint64_t> primitivePolynomials(const uint32_t count)
+{
+    std::vector<uint64_t> result;
+    for (uint32_t degree = 1; result.size() < count && degree < 32; degree++)
+    {
+        const std::vector<uint64_t> factors = primeFactors((uint64_t(1) << degree) - 1);
+        // x^degree + ... + 1: only the inner coefficients vary
+        const uint64_t inner = degree > 1 ? uint64_t(1) << (degree - 1) : 1;
+        for (uint64_t a = 0; a < inner && result.size() < count; a++)
+        {
+            const uint64_t p = (uint64_t(1) << degree) | (a << 1) | 1;
+            if (degree == 1 || isPrimitive(p, degree, factors))
+                result.push_back(p);
+        }
+    }
+    return result;
+}
+
+static uint32_t polynomialDegree(const uint64_t p)
+{
+    uint32_t degree = 0;
+    while ((p >> (degree + 1)) != 0)
+        degree++;
+    return degree;
+}
+
+// =============================================
+// ================== Sequence =================
+// =============================================
+
+SobolSequence::SobolSequence(const uint32_t dimension) :
+    dimensionCount(dimension), directions(size_t(dimension) * BITS)
+{
+    if (dimension == 0)
+        return;
+
+    // first dimension: van der Corput sequence
+    for (uint32_t i = 0; i < BITS; i++)
+    {
+        directions[i] = uint32_t(1) << (BITS - 1 - i);
+    }
+
+    const std::vector<uint64_t> polynomials = primitivePolynomials(dimension - 1);
+    for (uint32_t d = 1; d < dimension; d++)
+    {
+        const uint64_t p = polynomials[d - 1];
+        const uint32_t degree = polynomialDegree(p);
+        uint32_t * v = &directions[size_t(d) * BITS];
+
+        Random rng = Random::stream(SOBOL_SEED, d, 0);
+        for (uint32_t i = 0; i < degree && i < BITS; i++)
+        {
+            // m_i is odd and < 2^(i + 1)
+            const uint32_t m = d <= JOE_KUO_DIMENSIONS ? JOE_KUO_M[d - 1][i] : uint32_t(rng() >> (63 - i)) | 1;
+            v[i] = m << (BITS - 1 - i);
+        }
+
+        // recurrence of the polynomial's coefficients
+        for (uint32_t i = degree; i < BITS; i++)
+        {
+            v[i] = v[i - degree] ^ (v[i - degree] >> degree);
+            for (uint32_t k = 1; k < degree; k++)
+            {
+                if ((p >> (degree - k)) & 1)
+                    v[i] ^= v[i - k];
+            }
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#include "Telemetry.h"
+
+#include <chrono>
+#include <stdexcept>
+
+TelemetryWriter::TelemetryWriter(const std::string & filename, const Format format, const uint32_t capacity) :
+    format(format), file(filename), ring(capacity)
+{
+    if (!file)
+    {
+        throw std::runtime_error("Can't open telemetry file " + filename);
+    }
+    file.precision(10);
+
+    if (format == Format::Csv)
+    {
+        file << "iteration,evaluations,elapsedSeconds,best,mean,stddev,diversity,"
+                "eliteChildren,copiedChildren,classicCrossovers,linearCrossovers,heuristicCrossovers,"
+                "fineMutations,fullMutations,selectionSeconds,crossoverSeconds,mutationSeconds,evaluationSeconds\n";
+    }
+
+    drainThread = std::thread(&TelemetryWriter::drain, this);
+}
+
+TelemetryWriter::~TelemetryWriter()
+{
+    stopping.store(true, std::memory_order_release);
+    drainThread.join();
+}
+
+bool TelemetryWriter::push(const GenerationRecord & record)
+{
+    if (!ring.push(record))
+    {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    pushedCount.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+void TelemetryWriter::flush()
+{
+    const uint64_t target = pushedCount.load(std::memory_order_acquire);
+    while (writtenCount.load(std::memory_order_acquire) < target)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void TelemetryWriter::drain()
+{
+    GenerationRecord record;
+    while (true)
+    {
+        // check before emptying the ring, so that nothing pushed before the destructor is lost
+        const bool last = stopping.load(std::memory_order_acquire);
+
+        uint32_t count = 0;
+        while (ring.pop(record))
+        {
+            write(record);
+            count++;
+        }
+
+        if (count > 0)
+        {
+            file.flush();
+            writtenCount.fetch_add(count, std::memory_order_release);
+        }
+
+        if (last)
+            break;
+
+        // nothing to do - poll again later instead of making the producer signal us
+        if (count == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
+
+void TelemetryWriter::write(const GenerationRecord & r)
+{
+    if (format == Format::Csv)
+    {
+        file << r.iteration << ',' << r.evaluations << ',' << r.elapsedSeconds << ','
+             << r.best << ',' << r.mean << ',' << r.stddev << ',' << r.diversity << ','
+             << r.eliteChildren << ',' << r.copiedChildren << ',' << r.classicCrossovers << ','
+             << r.linearCrossovers << ',' << r.heuristicCrossovers << ','
+             << r.fineMutations << ',' << r.fullMutations << ','
+             << r.selectionSeconds << ',' << r.crossoverSeconds << ',' << r.mutationSeconds << ','
+             << r.evaluationSeconds << '\n';
+    }
+    else
+    {
+        file << "{\"iteration\":" << r.iteration << ",\"evaluations\":" << r.evaluations
+             << ",\"elapsedSeconds\":" << r.elapsedSeconds
+             << ",\"best\":" << r.best << ",\"mean\":" << r.mean << ",\"stddev\":" << r.stddev
+             << ",\"diversity\":" << r.diversity
+             << ",\"eliteChildren\":" << r.eliteChildren << ",\"copiedChildren\":" << r.copiedChildren
+             << ",\"classicCrossovers\":" << r.classicCrossovers << ",\"linearCrossovers\":" << r.linearCrossovers
+             << ",\"heuristicCrossovers\":" << r.heuristicCrossovers
+             << ",\"fineMutations\":" << r.fineMutations << ",\"fullMutations\":" << r.fullMutations
+             << ",\"selectionSeconds\":" << r.selectionSeconds << ",\"crossoverSeconds\":" << r.crossoverSeconds
+             << ",\"mutationSeconds\":" << r.mutationSeconds << ",\"evaluationSeconds\":" << r.evaluationSeconds
+             << "}\n";
+    }
+}
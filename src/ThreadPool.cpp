@@ -0,0 +1,128 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t threadCount) : threadCount(threadCount), nextChunk(0)
+{
+    if (this->threadCount == 0)
+    {
+        this->threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // the calling thread is worker 0
+    for (uint32_t i = 1; i < this->threadCount; i++)
+    {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    startCondition.notify_all();
+
+    for (auto & worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::run(uint32_t count, const void * body, Invoker invoker, uint32_t grainSize)
+{
+    if (count == 0)
+        return;
+
+    if (grainSize == 0)
+    {
+        // a few chunks per thread so that slow indices do not leave others idle
+        grainSize = std::max(1u, count / (4 * threadCount));
+    }
+
+    if (workers.empty() || count <= grainSize)
+    {
+        invoker(body, 0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = body;
+        jobInvoker = invoker;
+        jobCount = count;
+        jobGrain = grainSize;
+        jobError = nullptr;
+        nextChunk.store(0);
+        activeWorkers = workers.size();
+        jobGeneration++;
+    }
+    startCondition.notify_all();
+
+    runChunks(0);
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCondition.wait(lock, [&]() { return activeWorkers == 0; });
+        job = nullptr;
+        error = jobError;
+        jobError = nullptr;
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::workerLoop(const uint32_t threadIdx)
+{
+    uint64_t seenGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            startCondition.wait(lock, [&]() { return stopping || jobGeneration != seenGeneration; });
+            if (stopping)
+                return;
+            seenGeneration = jobGeneration;
+        }
+
+        runChunks(threadIdx);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            activeWorkers--;
+            if (activeWorkers == 0)
+                doneCondition.notify_one();
+        }
+    }
+}
+
+void ThreadPool::runChunks(const uint32_t threadIdx)
+{
+    const uint32_t chunkCount = (jobCount + jobGrain - 1) / jobGrain;
+    while (true)
+    {
+        const uint32_t chunk = nextChunk.fetch_add(1);
+        if (chunk >= chunkCount)
+            break;
+
+        const uint32_t begin = chunk * jobGrain;
+        const uint32_t end = std::min(jobCount, begin + jobGrain);
+        try
+        {
+            jobInvoker(job, begin, end, threadIdx);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!jobError)
+                jobError = std::current_exception();
+            // skip the remaining chunks
+            nextChunk.store(chunkCount);
+        }
+    }
+}
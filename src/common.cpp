@@ -1,5 +1,7 @@
 #include "common.h"
 
+#include <algorithm>
+
 void printVector(const Vector & x, std::ostream & stream, const std::string & separator)
 {
     stream << x[0];
@@ -14,3 +16,21 @@ std::ostream & operator<<(std::ostream & stream, const Vector & x)
     printVector(x, stream, ", ");
     return stream;
 }
+
+BatchObjectiveFunction makeBatchObjective(ObjectiveFunction objective)
+{
+    return [objective](const PopulationMatrix & population, double * outScores)
+    {
+        // reused between calls - the batch may be called from several threads at once
+        static thread_local Vector x;
+        if (x.size() != population.cols)
+            x.resize(population.cols);
+
+        for (uint32_t i = 0; i < population.rows; i++)
+        {
+            const double * row = population.row(i);
+            std::copy(row, row + population.cols, std::begin(x));
+            outScores[i] = objective(x);
+        }
+    };
+}
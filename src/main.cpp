@@ -3,64 +3,13 @@
 #include <cmath>
 #include <opencv2/opencv.hpp>
 
+#include "BatchObjectives.h"
 #include "Genocop.h"
+#include "Objectives.h"
 #include "OptimizationVideoWriter.h"
 
 cv::VideoWriter videoWriter;
 
-double objFunc1(const Vector & x)
-{
-    double val = x[0] + x[0] * std::sin(20 * x[0]);
-    return val;
-}
-
-double banana(const Vector & vec)
-{
-    const double a = 1;
-    const double b = 100;
-
-    const double x = vec[0];
-    const double y = vec[1];
-
-    double val = std::pow(a - x, 2) + b * std::pow(y - x * x, 2);
-    return val;
-}
-
-double rastrigin(const Vector & vec)
-{
-    const double a = 10;
-    const double PI = 3.14159265359;
-
-    const double x = vec[0];
-    const double y = vec[1];
-
-    double val = 2 * a + x * x + y * y - a * std::cos(2 * PI * x) - a * std::cos(2 * PI * y);
-    return val;
-}
-
-double himmelblau(const Vector & vec)
-{
-    const double a = 10;
-
-    const double x = vec[0];
-    const double y = vec[1];
-
-    double val = std::pow(x * x + y - 11, 2) + std::pow(x + y * y - 7, 2);
-    return val;
-}
-
-double levi13(const Vector & vec)
-{
-    const double a = 10;
-    const double PI = 3.14159265359;
-
-    const double x = vec[0];
-    const double y = vec[1];
-
-    double val = std::pow(std::sin(3 * PI * x), 2) + std::pow(x - 1, 2) * (1 + std::pow(std::sin(3 * PI * y), 2)) + std::pow(y - 1, 2) * (1 + std::pow(std::sin(3 * PI * x), 2));
-    return val;
-}
-
 void run1d()
 {
     // ranges
@@ -104,10 +53,10 @@ void run2d()
     video.begin("banana.mp4");
     video.drawBackground(banana, 0.3);
 
-    optim.callback = [&video](const std::vector<Genocop::Score> & population)
+    optim.subscribe([&video](const Genocop::PopulationView & population)
     {
         video.drawFrame(population);
-    };
+    });
 
     Vector solution(1);
     double minVal = optim.run(solution, options);
@@ -140,12 +89,21 @@ void run2d_rastrigin()
     // video output
     OptimizationVideoWriter video(1024, 1024, -5.12, 5.12, -5.12, 5.12);
     video.begin("rastrigin.mp4");
-    video.drawBackground(rastrigin, 1.0);
 
-    optim.callback = [&video](const std::vector<Genocop::Score> & population)
+    // whole rows of the vectorized version on all threads, with a coarse preview first
+    OptimizationVideoWriter::BackgroundOptions background;
+    background.threadCount = 0;
+    background.coarseLevels = 3;
+    background.preview = [](const cv::Mat &, uint32_t level)
     {
-        video.drawFrame(population);
+        std::cout << "Background preview, level " << level << "\n";
     };
+    video.drawBackground(makeTestFunction(TestFunction::Rastrigin), 1.0, background);
+
+    optim.subscribe([&video](const Genocop::PopulationView & population)
+    {
+        video.drawFrame(population);
+    });
 
     Vector solution(2);
     double minVal = optim.run(solution, options);
@@ -180,10 +138,10 @@ void run2d_himmelblau()
     video.begin("himmelblau.mp4");
     video.drawBackground(himmelblau, 0.5);
 
-    optim.callback = [&video](const std::vector<Genocop::Score> & population)
+    optim.subscribe([&video](const Genocop::PopulationView & population)
     {
         video.drawFrame(population);
-    };
+    });
 
     Vector solution(2);
     double minVal = optim.run(solution, options);
@@ -218,10 +176,10 @@ void run2d_levi13()
     video.begin("levi13.mp4");
     video.drawBackground(levi13, 0.5);
 
-    optim.callback = [&video](const std::vector<Genocop::Score> & population)
+    optim.subscribe([&video](const Genocop::PopulationView & population)
     {
         video.drawFrame(population);
-    };
+    });
 
     Vector solution(2);
     double minVal = optim.run(solution, options);
@@ -229,16 +187,6 @@ void run2d_levi13()
     std::cout << "Min value: " << minVal << " at x = " << solution  << "\n"; 
 }
 
-double f2d(const Vector & vec)
-{
-    double x = vec[0];
-    double y = vec[1];
-    double sum = x * x + 10.0 * y * y;
-    double val = sum * sum;
-    //double val = std::pow(x + 10.0 * y, 2);
-    return val;
-}
-
 void run2d_f()
 {
     // ranges
@@ -266,10 +214,14 @@ void run2d_f()
     video.begin("poly.mp4");
     video.drawBackground(f2d, 0.2);
 
-    optim.callback = [&video](const std::vector<Genocop::Score> & population)
+    optim.subscribe([&video](const Genocop::PopulationView & population)
     {
         video.drawFrame(population);
-    };
+    });
+
+    // per-generation statistics
+    TelemetryWriter telemetry("poly.csv", TelemetryWriter::Format::Csv);
+    optim.telemetry = &telemetry;
 
     Vector solution;
     double minVal = optim.run(solution, options);
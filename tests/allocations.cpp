@@ -0,0 +1,68 @@
+#include <iostream>
+
+#include "AllocationCounter.h"
+#include "Genocop.h"
+
+// The generation loop must not allocate once it has warmed up.
+// Returns the number of failed checks
+static int checkAllocations(const uint32_t threadCount)
+{
+    const uint32_t N = 200;
+    Vector xMin(-5.12, N);
+    Vector xMax(5.12, N);
+
+    // a batch objective - the adapter of makeBatchObjective allocates once per worker thread,
+    // and a worker may see its first chunk only after the warm-up
+    auto sphere = [](const PopulationMatrix & population, double * outScores)
+    {
+        for (uint32_t i = 0; i < population.rows; i++)
+        {
+            const double * row = population.row(i);
+            double sum = 0;
+            for (uint32_t k = 0; k < population.cols; k++)
+                sum += row[k] * row[k];
+            outScores[i] = sum;
+        }
+    };
+
+    Genocop optim(N, sphere, xMin, xMax);
+
+    Genocop::Options options;
+    options.populationCount = 500;
+    options.parentsCount = 200;
+    options.eliteChildrenCount = 2;
+    options.maxIters = 50;
+    options.threadCount = threadCount;
+    options.seed = 1;
+    options.crossover.totalProbability = 0.8;
+
+    // the first iterations may allocate (callback buffers, thread local storage)
+    const uint32_t WARM_UP = 2;
+    uint32_t iter = 0;
+    uint64_t startCount = 0;
+    uint64_t endCount = 0;
+
+    optim.callback = [&](const std::vector<Genocop::Score> &)
+    {
+        if (iter == WARM_UP)
+            startCount = getAllocationCount();
+        endCount = getAllocationCount();
+        iter++;
+    };
+
+    Vector solution;
+    optim.run(solution, options);
+
+    const uint64_t allocations = endCount - startCount;
+    std::cout << "Threads: " << threadCount << ", allocations in " << iter - 1 - WARM_UP
+              << " generations after warm-up: " << allocations << "\n";
+    return allocations == 0 ? 0 : 1;
+}
+
+int main()
+{
+    int failures = 0;
+    failures += checkAllocations(1);
+    failures += checkAllocations(4);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+#include "Genocop.h"
+#include "LinearConstraints.h"
+
+// With linear constraints the objective must only see points inside the box that satisfy them
+// (up to rounding). Returns the number of failed checks
+static int checkFeasibleCalls(const char * name, const LinearConstraints & constraints,
+                              const std::vector<Vector> & equalityA, const Vector & equalityB,
+                              const std::vector<Vector> & inequalityA, const Vector & inequalityB,
+                              const Vector & xMin, const Vector & xMax, const Vector & c, const double minimum)
+{
+    const uint32_t N = xMin.size();
+
+    // rounding tolerance of a . x = b for |x| within the box
+    auto tolerance = [&](const Vector & a, const double b)
+    {
+        double magnitude = std::abs(b);
+        for (uint32_t k = 0; k < N; k++)
+            magnitude += std::abs(a[k]) * std::max(std::abs(xMin[k]), std::abs(xMax[k]));
+        return 1e-11 * magnitude;
+    };
+
+    uint64_t calls = 0;
+    uint64_t outsideBox = 0;
+    uint64_t violations = 0;
+    auto objective = [&](const Vector & x)
+    {
+        calls++;
+        for (uint32_t k = 0; k < N; k++)
+        {
+            if (x[k] < xMin[k] || x[k] > xMax[k])
+            {
+                outsideBox++;
+                break;
+            }
+        }
+        bool violated = false;
+        for (size_t i = 0; i < equalityA.size(); i++)
+            violated |= std::abs((equalityA[i] * x).sum() - equalityB[i]) > tolerance(equalityA[i], equalityB[i]);
+        for (size_t i = 0; i < inequalityA.size(); i++)
+            violated |= (inequalityA[i] * x).sum() - inequalityB[i] > tolerance(inequalityA[i], inequalityB[i]);
+        violations += violated;
+        return (c * x).sum();
+    };
+
+    Genocop optim(N, objective, xMin, xMax);
+    optim.setConstraints(constraints);
+
+    Genocop::Options options;
+    options.populationCount = 100;
+    options.parentsCount = 45;
+    options.maxIters = 100;
+    options.threadCount = 1;
+    options.seed = 1;
+    options.crossover.totalProbability = 0.8;
+    options.localSearch.interval = 20;
+    options.localSearch.polishEvaluations = 500;
+
+    Vector solution;
+    const double best = optim.run(solution, options);
+
+    std::cout << name << ": best " << best << " (minimum " << minimum << "), " << calls << " calls, "
+              << outsideBox << " outside the box, " << violations << " violating the constraints\n";
+    int failures = 0;
+    failures += outsideBox != 0;
+    failures += violations != 0;
+    failures += best < minimum - 1e-9;
+    return failures;
+}
+
+int main()
+{
+    int failures = 0;
+
+    // sum(x) = 0 in [-1, 1]^4, minimum of -x0 + x1 is -2
+    {
+        const uint32_t N = 4;
+        const Vector ones(1.0, N);
+        LinearConstraints constraints(N);
+        constraints.addEquality(ones, 0);
+        failures += checkFeasibleCalls("equality", constraints, {ones}, {0.0}, {}, {},
+                                       Vector(-1.0, N), Vector(1.0, N), {-1, 1, 0, 0}, -2);
+    }
+
+    // two equalities and two inequalities in [-10, 10]^5; the minimum of the linear objective is on the
+    // boundary (not checked, only the calls are)
+    {
+        const uint32_t N = 5;
+        const Vector eq0 = {1, 1, 1, 0, 0};
+        const Vector eq1 = {0, 1, -1, 1, 0};
+        const Vector in0 = {1, 0, 0, 1, 1};
+        const Vector in1 = {0, 2, 0, 0, -1};
+        LinearConstraints constraints(N);
+        constraints.addEquality(eq0, 2.0);
+        constraints.addEquality(eq1, 0.5);
+        constraints.addInequality(in0, 1.3);
+        constraints.addInequality(in1, 3.0);
+        failures += checkFeasibleCalls("inequalities", constraints, {eq0, eq1}, {2.0, 0.5}, {in0, in1}, {1.3, 3.0},
+                                       Vector(-10.0, N), Vector(10.0, N), {-1, 1, 0.5, -0.5, 1},
+                                       -std::numeric_limits<double>::infinity());
+    }
+
+    return failures == 0 ? 0 : 1;
+}